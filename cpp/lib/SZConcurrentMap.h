@@ -0,0 +1,401 @@
+#pragma once
+
+#include "SZUtility.h"
+#include "SZSpinMutex.h"
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+/**
+ * @brief 分段加锁的并发哈希表
+ *        每段独立加锁、独立扩容, 段内为线性探测的开放寻址表, 删除时后移回填不留墓碑
+ *        find返回值的拷贝, 不暴露内部引用
+ *
+ * @tparam K
+ * @tparam V
+ * @tparam Hash
+ * @tparam KeyEqual
+ * @tparam ShardNum 段数, 须为2的幂
+ * @tparam Mutex 段锁类型
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>,
+		  size_t ShardNum = 16, typename Mutex = SZ_SpinMutex>
+class SZ_ConcurrentMap : public SZ_Uncopy
+{
+	static_assert(ShardNum > 0 && ShardNum <= 65536 && (ShardNum & (ShardNum - 1)) == 0, "ShardNum must be a power of two no greater than 65536");
+
+public:
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef std::pair<K, V> value_type;
+
+public:
+	SZ_ConcurrentMap() : SZ_ConcurrentMap(0) {}
+
+	/**
+	 * @brief
+	 *
+	 * @param cap 预期元素总数, 平均分配到各段
+	 */
+	explicit SZ_ConcurrentMap(size_t cap)
+	{
+		for (auto &shard : shards_)
+		{
+			shard.reserve(cap / ShardNum);
+		}
+	}
+
+	~SZ_ConcurrentMap() {}
+
+	/**
+	 * @brief 查找, 命中时拷贝到value
+	 *
+	 * @param key
+	 * @param value
+	 * @return bool
+	 */
+	bool find(const key_type &key, mapped_type &value) const
+	{
+		size_t hash = hashOf(key);
+		const Shard &shard = shardOf(hash);
+
+		std::lock_guard<Mutex> locker(shard.mtx);
+		size_t i = shard.lookup(key, hash, equal_);
+		if (i == Shard::NPOS)
+		{
+			return false;
+		}
+		value = shard.slots[i].second;
+
+		return true;
+	}
+
+	/**
+	 * @brief 是否存在
+	 *
+	 * @param key
+	 * @return bool
+	 */
+	bool contains(const key_type &key) const
+	{
+		size_t hash = hashOf(key);
+		const Shard &shard = shardOf(hash);
+
+		std::lock_guard<Mutex> locker(shard.mtx);
+		return shard.lookup(key, hash, equal_) != Shard::NPOS;
+	}
+
+	/**
+	 * @brief 插入或覆盖
+	 *
+	 * @param key
+	 * @param value
+	 * @return bool 新插入返回true, 覆盖返回false
+	 */
+	template <typename M>
+	bool insert_or_assign(const key_type &key, M &&value)
+	{
+		size_t hash = hashOf(key);
+		Shard &shard = shardOf(hash);
+
+		std::lock_guard<Mutex> locker(shard.mtx);
+		size_t i = shard.lookup(key, hash, equal_);
+		if (i != Shard::NPOS)
+		{
+			shard.slots[i].second = std::forward<M>(value);
+			return false;
+		}
+		shard.emplace(hash, key, std::forward<M>(value));
+
+		return true;
+	}
+
+	/**
+	 * @brief 不存在时以factory()的结果插入, 同一key的factory只会被调用一次
+	 *        factory在段锁内执行, 不可重入本表同段
+	 *
+	 * @param key
+	 * @param factory
+	 * @return mapped_type 已有或新插入的值
+	 */
+	template <typename Factory>
+	mapped_type compute_if_absent(const key_type &key, Factory &&factory)
+	{
+		size_t hash = hashOf(key);
+		Shard &shard = shardOf(hash);
+
+		std::lock_guard<Mutex> locker(shard.mtx);
+		size_t i = shard.lookup(key, hash, equal_);
+		if (i == Shard::NPOS)
+		{
+			i = shard.emplace(hash, key, factory());
+		}
+
+		return shard.slots[i].second;
+	}
+
+	/**
+	 * @brief 删除
+	 *
+	 * @param key
+	 * @return bool
+	 */
+	bool erase(const key_type &key)
+	{
+		size_t hash = hashOf(key);
+		Shard &shard = shardOf(hash);
+
+		std::lock_guard<Mutex> locker(shard.mtx);
+		size_t i = shard.lookup(key, hash, equal_);
+		if (i == Shard::NPOS)
+		{
+			return false;
+		}
+		shard.remove(i);
+
+		return true;
+	}
+
+	/**
+	 * @brief 元素个数, 各段分别加锁统计, 并发修改时仅为近似值
+	 *
+	 * @return size_t
+	 */
+	size_t size() const
+	{
+		size_t n = 0;
+		for (auto &shard : shards_)
+		{
+			std::lock_guard<Mutex> locker(shard.mtx);
+			n += shard.size;
+		}
+
+		return n;
+	}
+
+	/**
+	 * @brief 是否为空
+	 *
+	 * @return bool
+	 */
+	bool isEmpty() const
+	{
+		return size() == 0;
+	}
+
+	/**
+	 * @brief 清空元素
+	 */
+	void clear()
+	{
+		for (auto &shard : shards_)
+		{
+			std::lock_guard<Mutex> locker(shard.mtx);
+			shard.release();
+		}
+	}
+
+	/**
+	 * @brief 逐段加锁遍历, func(const K &, const V &)
+	 *
+	 * @param func
+	 */
+	template <typename Func>
+	void forEach(Func &&func) const
+	{
+		for (auto &shard : shards_)
+		{
+			std::lock_guard<Mutex> locker(shard.mtx);
+			for (size_t i = 0; i < shard.capacity; ++i)
+			{
+				if (shard.hashes[i] != 0)
+				{
+					func(shard.slots[i].first, shard.slots[i].second);
+				}
+			}
+		}
+	}
+
+private:
+	struct alignas(64) Shard
+	{
+		static constexpr size_t NPOS = static_cast<size_t>(-1);
+		static constexpr size_t MIN_CAPACITY = 8;
+
+		mutable Mutex mtx;
+		size_t size;
+		size_t capacity;
+		std::unique_ptr<size_t[]> hashes; // 0表示空槽, 其余为最高位置1的哈希值
+		value_type *slots;
+
+		Shard() : size(0), capacity(0), slots(nullptr) {}
+
+		~Shard()
+		{
+			release();
+		}
+
+		void reserve(size_t n)
+		{
+			size_t cap = MIN_CAPACITY;
+			while (cap * 3 < n * 4)
+			{
+				cap <<= 1;
+			}
+			if (cap > capacity)
+			{
+				rehash(cap);
+			}
+		}
+
+		size_t lookup(const key_type &key, size_t hash, const KeyEqual &equal) const
+		{
+			if (0 == size)
+			{
+				return NPOS;
+			}
+
+			size_t mask = capacity - 1;
+			for (size_t i = hash & mask;; i = (i + 1) & mask)
+			{
+				if (hashes[i] == 0)
+				{
+					return NPOS;
+				}
+				if (hashes[i] == hash && equal(slots[i].first, key))
+				{
+					return i;
+				}
+			}
+		}
+
+		template <typename M>
+		size_t emplace(size_t hash, const key_type &key, M &&value)
+		{
+			if ((size + 1) * 4 > capacity * 3)
+			{
+				rehash(capacity == 0 ? MIN_CAPACITY : capacity * 2);
+			}
+
+			size_t i = probe(hash);
+			new (&slots[i]) value_type(key, std::forward<M>(value));
+			hashes[i] = hash;
+			++size;
+
+			return i;
+		}
+
+		void remove(size_t i)
+		{
+			size_t mask = capacity - 1;
+			slots[i].~value_type();
+			hashes[i] = 0;
+			--size;
+
+			// 后移回填: 把探测链上可以前移的元素挪到空槽
+			for (size_t j = (i + 1) & mask; hashes[j] != 0; j = (j + 1) & mask)
+			{
+				size_t home = hashes[j] & mask;
+				bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+				if (movable)
+				{
+					new (&slots[i]) value_type(std::move(slots[j]));
+					hashes[i] = hashes[j];
+					slots[j].~value_type();
+					hashes[j] = 0;
+					i = j;
+				}
+			}
+		}
+
+		size_t probe(size_t hash) const
+		{
+			size_t mask = capacity - 1;
+			size_t i = hash & mask;
+			while (hashes[i] != 0)
+			{
+				i = (i + 1) & mask;
+			}
+
+			return i;
+		}
+
+		void rehash(size_t cap)
+		{
+			std::unique_ptr<size_t[]> oldHashes(std::move(hashes));
+			value_type *oldSlots = slots;
+			size_t oldCapacity = capacity;
+
+			hashes.reset(new size_t[cap]());
+			slots = std::allocator<value_type>().allocate(cap);
+			capacity = cap;
+
+			for (size_t i = 0; i < oldCapacity; ++i)
+			{
+				if (oldHashes[i] != 0)
+				{
+					size_t j = probe(oldHashes[i]);
+					new (&slots[j]) value_type(std::move(oldSlots[i]));
+					hashes[j] = oldHashes[i];
+					oldSlots[i].~value_type();
+				}
+			}
+
+			if (nullptr != oldSlots)
+			{
+				std::allocator<value_type>().deallocate(oldSlots, oldCapacity);
+			}
+		}
+
+		void release()
+		{
+			for (size_t i = 0; i < capacity; ++i)
+			{
+				if (hashes[i] != 0)
+				{
+					slots[i].~value_type();
+				}
+			}
+			if (nullptr != slots)
+			{
+				std::allocator<value_type>().deallocate(slots, capacity);
+			}
+
+			hashes.reset();
+			slots = nullptr;
+			size = 0;
+			capacity = 0;
+		}
+	};
+
+	size_t hashOf(const key_type &key) const
+	{
+		// std::hash对整数是恒等映射, 混合后高位选段、低位选槽
+		uint64_t h = static_cast<uint64_t>(hash_(key));
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+
+		return static_cast<size_t>(h) | (static_cast<size_t>(1) << (sizeof(size_t) * 8 - 1));
+	}
+
+	Shard &shardOf(size_t hash)
+	{
+		return shards_[(hash >> (sizeof(size_t) * 8 - 17)) & (ShardNum - 1)];
+	}
+
+	const Shard &shardOf(size_t hash) const
+	{
+		return shards_[(hash >> (sizeof(size_t) * 8 - 17)) & (ShardNum - 1)];
+	}
+
+private:
+	Hash hash_;
+	KeyEqual equal_;
+	std::array<Shard, ShardNum> shards_;
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "SZUtility.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace SZ_CounterDetail
+{
+	/**
+	 * @brief 当前线程的槽位序号, 线程首次使用时轮转分配
+	 *
+	 * @return size_t
+	 */
+	inline size_t threadSlot()
+	{
+		static std::atomic_size_t next(0);
+		static thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+		return slot;
+	}
+
+	inline void storeMin(std::atomic<int64_t> &target, int64_t value)
+	{
+		int64_t current = target.load(std::memory_order_relaxed);
+		while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	inline void storeMax(std::atomic<int64_t> &target, int64_t value)
+	{
+		int64_t current = target.load(std::memory_order_relaxed);
+		while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+		{
+		}
+	}
+} // namespace SZ_CounterDetail
+
+/**
+ * @brief 分片计数器, 每个线程写自己独占缓存行的槽位, 读取时汇总
+ *        写操作为无竞争的原子加, 读操作为O(SlotNum), 适合写多读少的统计
+ *        支持++/--, 可直接配合SZ_Raii使用
+ *
+ * @tparam SlotNum 槽位数, 须为2的幂, 线程数超过槽位数时共享槽位, 结果仍然正确
+ */
+template <size_t SlotNum = 64>
+class SZ_ShardedCounter : public SZ_Uncopy
+{
+	static_assert(SlotNum > 0 && (SlotNum & (SlotNum - 1)) == 0, "SlotNum must be a power of two");
+
+public:
+	SZ_ShardedCounter() { reset(); }
+
+	~SZ_ShardedCounter() {}
+
+	/**
+	 * @brief 增加n
+	 *
+	 * @param n
+	 */
+	void add(int64_t n)
+	{
+		slots_[SZ_CounterDetail::threadSlot() & (SlotNum - 1)].value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	SZ_ShardedCounter &operator++()
+	{
+		add(1);
+		return *this;
+	}
+
+	SZ_ShardedCounter &operator--()
+	{
+		add(-1);
+		return *this;
+	}
+
+	SZ_ShardedCounter &operator+=(int64_t n)
+	{
+		add(n);
+		return *this;
+	}
+
+	SZ_ShardedCounter &operator-=(int64_t n)
+	{
+		add(-n);
+		return *this;
+	}
+
+	/**
+	 * @brief 汇总各槽位, 并发写入时为近似值
+	 *
+	 * @return int64_t
+	 */
+	int64_t value() const
+	{
+		int64_t sum = 0;
+		for (auto &slot : slots_)
+		{
+			sum += slot.value.load(std::memory_order_relaxed);
+		}
+		return sum;
+	}
+
+	/**
+	 * @brief 清零, 与并发写入同时进行时可能丢失部分增量
+	 */
+	void reset()
+	{
+		for (auto &slot : slots_)
+		{
+			slot.value.store(0, std::memory_order_relaxed);
+		}
+	}
+
+protected:
+	struct alignas(64) Slot
+	{
+		std::atomic<int64_t> value;
+	};
+
+	Slot slots_[SlotNum];
+};
+
+/**
+ * @brief 分片计量值, 用于在线数、活跃任务数等可增可减的量
+ *
+ * @tparam SlotNum
+ */
+template <size_t SlotNum = 64>
+class SZ_ShardedGauge : public SZ_ShardedCounter<SlotNum>
+{
+public:
+	SZ_ShardedGauge &operator++()
+	{
+		this->add(1);
+		return *this;
+	}
+
+	SZ_ShardedGauge &operator--()
+	{
+		this->add(-1);
+		return *this;
+	}
+
+	/**
+	 * @brief 设置为value, 通过补差实现, 并发写入时为近似值
+	 *
+	 * @param value
+	 */
+	void set(int64_t value)
+	{
+		this->add(value - this->value());
+	}
+};
+
+/**
+ * @brief 分片统计累加器, 记录次数、总和、最小值、最大值
+ *
+ * @tparam SlotNum
+ */
+template <size_t SlotNum = 64>
+class SZ_ShardedStats : public SZ_Uncopy
+{
+	static_assert(SlotNum > 0 && (SlotNum & (SlotNum - 1)) == 0, "SlotNum must be a power of two");
+
+public:
+	struct Snapshot
+	{
+		int64_t count;
+		int64_t sum;
+		int64_t min; // count为0时无意义
+		int64_t max; // count为0时无意义
+
+		double mean() const { return count > 0 ? static_cast<double>(sum) / count : 0.0; }
+	};
+
+public:
+	SZ_ShardedStats() { reset(); }
+
+	~SZ_ShardedStats() {}
+
+	/**
+	 * @brief 记录一个样本
+	 *
+	 * @param value
+	 */
+	void record(int64_t value)
+	{
+		Slot &slot = slots_[SZ_CounterDetail::threadSlot() & (SlotNum - 1)];
+		slot.count.fetch_add(1, std::memory_order_relaxed);
+		slot.sum.fetch_add(value, std::memory_order_relaxed);
+		SZ_CounterDetail::storeMin(slot.min, value);
+		SZ_CounterDetail::storeMax(slot.max, value);
+	}
+
+	/**
+	 * @brief 汇总各槽位
+	 *
+	 * @return Snapshot
+	 */
+	Snapshot snapshot() const
+	{
+		Snapshot snap = {0, 0, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min()};
+		for (auto &slot : slots_)
+		{
+			snap.count += slot.count.load(std::memory_order_relaxed);
+			snap.sum += slot.sum.load(std::memory_order_relaxed);
+			snap.min = std::min(snap.min, slot.min.load(std::memory_order_relaxed));
+			snap.max = std::max(snap.max, slot.max.load(std::memory_order_relaxed));
+		}
+		return snap;
+	}
+
+	/**
+	 * @brief 清空
+	 */
+	void reset()
+	{
+		for (auto &slot : slots_)
+		{
+			slot.count.store(0, std::memory_order_relaxed);
+			slot.sum.store(0, std::memory_order_relaxed);
+			slot.min.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+			slot.max.store(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct alignas(64) Slot
+	{
+		std::atomic<int64_t> count;
+		std::atomic<int64_t> sum;
+		std::atomic<int64_t> min;
+		std::atomic<int64_t> max;
+	};
+
+	Slot slots_[SlotNum];
+};
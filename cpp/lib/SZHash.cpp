@@ -0,0 +1,947 @@
+#include "SZHash.h"
+#include "SZMD5.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SZ_HASH_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    inline uint64_t read64(const unsigned char *p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint32_t read32(const unsigned char *p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t swap64(uint64_t v)
+    {
+#if defined _MSC_VER
+        return _byteswap_uint64(v);
+#else
+        return __builtin_bswap64(v);
+#endif
+    }
+
+    inline uint32_t swap32(uint32_t v)
+    {
+#if defined _MSC_VER
+        return _byteswap_ulong(v);
+#else
+        return __builtin_bswap32(v);
+#endif
+    }
+
+    inline uint64_t rotl64(uint64_t v, int n)
+    {
+        return (v << n) | (v >> (64 - n));
+    }
+
+    inline uint32_t rotr32(uint32_t v, int n)
+    {
+        return (v >> n) | (v << (32 - n));
+    }
+
+    /**
+     * @brief 分块读取文件, 打开或读取失败时抛出异常
+     */
+    void readFile(const std::string &fileName, const SZ_MD5::ReadCallback &callback)
+    {
+        std::string sErr;
+        if (!SZ_MD5::readFile(fileName, callback, sErr))
+        {
+            throw SZ_Hash_Exception(sErr);
+        }
+    }
+}
+
+/************************************************************************************************
+ * XXH3
+ ************************************************************************************************/
+
+namespace
+{
+    const uint64_t PRIME32_1 = 0x9E3779B1U;
+    const uint64_t PRIME32_2 = 0x85EBCA77U;
+    const uint64_t PRIME32_3 = 0xC2B2AE3DU;
+    const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+    const size_t STRIPE_LEN = 64;
+    const size_t SECRET_CONSUME_RATE = 8;
+    const size_t SECRET_SIZE = 192;
+    const size_t SECRET_MERGEACCS_START = 11;
+    const size_t SECRET_LASTACC_START = 7;
+    const size_t MID_SIZE_MAX = 240;
+    const size_t INTERNAL_BUFFER_SIZE = 256;
+    const size_t STRIPES_PER_BLOCK = (SECRET_SIZE - STRIPE_LEN) / SECRET_CONSUME_RATE;
+
+    const unsigned char DEFAULT_SECRET[SECRET_SIZE] = {
+        0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+        0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+        0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+        0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+        0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+        0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+        0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+        0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+        0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+        0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+        0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+        0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    const uint64_t INITIAL_ACC[8] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+
+    inline uint64_t mul128Fold64(uint64_t lhs, uint64_t rhs)
+    {
+#if defined __SIZEOF_INT128__
+        unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+        uint64_t lolo = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+        uint64_t hilo = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+        uint64_t lohi = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+        uint64_t hihi = (lhs >> 32) * (rhs >> 32);
+        uint64_t cross = (lolo >> 32) + (hilo & 0xFFFFFFFF) + lohi;
+        uint64_t upper = (hilo >> 32) + (cross >> 32) + hihi;
+        uint64_t lower = (cross << 32) | (lolo & 0xFFFFFFFF);
+        return lower ^ upper;
+#endif
+    }
+
+    inline uint64_t xxh64Avalanche(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= PRIME64_2;
+        h ^= h >> 29;
+        h *= PRIME64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline uint64_t xxh3Avalanche(uint64_t h)
+    {
+        h ^= h >> 37;
+        h *= 0x165667919E3779F9ULL;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline uint64_t rrmxmx(uint64_t h, uint64_t length)
+    {
+        h ^= rotl64(h, 49) ^ rotl64(h, 24);
+        h *= 0x9FB21C651E98DF25ULL;
+        h ^= (h >> 35) + length;
+        h *= 0x9FB21C651E98DF25ULL;
+        h ^= h >> 28;
+        return h;
+    }
+
+    inline uint64_t mix16B(const unsigned char *input, const unsigned char *secret, uint64_t seed)
+    {
+        uint64_t lo = read64(input) ^ (read64(secret) + seed);
+        uint64_t hi = read64(input + 8) ^ (read64(secret + 8) - seed);
+        return mul128Fold64(lo, hi);
+    }
+
+    uint64_t xxh3Len1To3(const unsigned char *input, size_t length, const unsigned char *secret, uint64_t seed)
+    {
+        uint32_t c1 = input[0];
+        uint32_t c2 = input[length >> 1];
+        uint32_t c3 = input[length - 1];
+        uint32_t combined = (c1 << 16) | (c2 << 24) | c3 | (static_cast<uint32_t>(length) << 8);
+        uint64_t flip = static_cast<uint64_t>(read32(secret) ^ read32(secret + 4)) + seed;
+        return xxh64Avalanche(combined ^ flip);
+    }
+
+    uint64_t xxh3Len4To8(const unsigned char *input, size_t length, const unsigned char *secret, uint64_t seed)
+    {
+        seed ^= static_cast<uint64_t>(swap32(static_cast<uint32_t>(seed))) << 32;
+        uint32_t input1 = read32(input);
+        uint32_t input2 = read32(input + length - 4);
+        uint64_t flip = (read64(secret + 8) ^ read64(secret + 16)) - seed;
+        uint64_t input64 = input2 + (static_cast<uint64_t>(input1) << 32);
+        return rrmxmx(input64 ^ flip, length);
+    }
+
+    uint64_t xxh3Len9To16(const unsigned char *input, size_t length, const unsigned char *secret, uint64_t seed)
+    {
+        uint64_t flip1 = (read64(secret + 24) ^ read64(secret + 32)) + seed;
+        uint64_t flip2 = (read64(secret + 40) ^ read64(secret + 48)) - seed;
+        uint64_t lo = read64(input) ^ flip1;
+        uint64_t hi = read64(input + length - 8) ^ flip2;
+        uint64_t acc = length + swap64(lo) + hi + mul128Fold64(lo, hi);
+        return xxh3Avalanche(acc);
+    }
+
+    uint64_t xxh3Len17To128(const unsigned char *input, size_t length, const unsigned char *secret, uint64_t seed)
+    {
+        uint64_t acc = length * PRIME64_1;
+        if (length > 32)
+        {
+            if (length > 64)
+            {
+                if (length > 96)
+                {
+                    acc += mix16B(input + 48, secret + 96, seed);
+                    acc += mix16B(input + length - 64, secret + 112, seed);
+                }
+                acc += mix16B(input + 32, secret + 64, seed);
+                acc += mix16B(input + length - 48, secret + 80, seed);
+            }
+            acc += mix16B(input + 16, secret + 32, seed);
+            acc += mix16B(input + length - 32, secret + 48, seed);
+        }
+        acc += mix16B(input, secret, seed);
+        acc += mix16B(input + length - 16, secret + 16, seed);
+        return xxh3Avalanche(acc);
+    }
+
+    uint64_t xxh3Len129To240(const unsigned char *input, size_t length, const unsigned char *secret, uint64_t seed)
+    {
+        uint64_t acc = length * PRIME64_1;
+        size_t rounds = length / 16;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            acc += mix16B(input + 16 * i, secret + 16 * i, seed);
+        }
+        acc = xxh3Avalanche(acc);
+        for (size_t i = 8; i < rounds; ++i)
+        {
+            acc += mix16B(input + 16 * i, secret + 16 * (i - 8) + 3, seed);
+        }
+        acc += mix16B(input + length - 16, secret + 136 - 17, seed);
+        return xxh3Avalanche(acc);
+    }
+
+    void accumulateScalar(uint64_t *acc, const unsigned char *input, const unsigned char *secret, size_t stripes)
+    {
+        for (size_t n = 0; n < stripes; ++n)
+        {
+            const unsigned char *in = input + n * STRIPE_LEN;
+            const unsigned char *key = secret + n * SECRET_CONSUME_RATE;
+            for (size_t i = 0; i < 8; ++i)
+            {
+                uint64_t data = read64(in + 8 * i);
+                uint64_t mixed = data ^ read64(key + 8 * i);
+                acc[i ^ 1] += data;
+                acc[i] += (mixed & 0xFFFFFFFF) * (mixed >> 32);
+            }
+        }
+    }
+
+    void scrambleScalar(uint64_t *acc, const unsigned char *secret)
+    {
+        for (size_t i = 0; i < 8; ++i)
+        {
+            uint64_t v = acc[i];
+            v ^= v >> 47;
+            v ^= read64(secret + 8 * i);
+            acc[i] = v * PRIME32_1;
+        }
+    }
+
+#if defined SZ_HASH_X86
+    __attribute__((target("avx2"))) void accumulateAVX2(uint64_t *acc, const unsigned char *input, const unsigned char *secret, size_t stripes)
+    {
+        __m256i acc0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc));
+        __m256i acc1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc + 4));
+        for (size_t n = 0; n < stripes; ++n)
+        {
+            const unsigned char *in = input + n * STRIPE_LEN;
+            const unsigned char *key = secret + n * SECRET_CONSUME_RATE;
+
+            __m256i data0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+            __m256i data1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 32));
+            __m256i key0 = _mm256_xor_si256(data0, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(key)));
+            __m256i key1 = _mm256_xor_si256(data1, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(key + 32)));
+            __m256i prod0 = _mm256_mul_epu32(key0, _mm256_srli_epi64(key0, 32));
+            __m256i prod1 = _mm256_mul_epu32(key1, _mm256_srli_epi64(key1, 32));
+            // 相邻两个64位通道交换后累加原始数据
+            acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(prod0, _mm256_shuffle_epi32(data0, 0x4E)));
+            acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(prod1, _mm256_shuffle_epi32(data1, 0x4E)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc), acc0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc + 4), acc1);
+    }
+
+    __attribute__((target("avx2"))) void scrambleAVX2(uint64_t *acc, const unsigned char *secret)
+    {
+        const __m256i prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+        for (size_t i = 0; i < 2; ++i)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc + 4 * i));
+            v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 47));
+            v = _mm256_xor_si256(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(secret + 32 * i)));
+            __m256i lo = _mm256_mul_epu32(v, prime);
+            __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(v, 32), prime);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc + 4 * i), _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+        }
+    }
+#endif // SZ_HASH_X86
+
+    typedef void (*AccumulateFunc)(uint64_t *, const unsigned char *, const unsigned char *, size_t);
+    typedef void (*ScrambleFunc)(uint64_t *, const unsigned char *);
+
+    struct XXH3Kernel
+    {
+        AccumulateFunc accumulate;
+        ScrambleFunc scramble;
+
+        XXH3Kernel() : accumulate(accumulateScalar), scramble(scrambleScalar)
+        {
+#if defined SZ_HASH_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                accumulate = accumulateAVX2;
+                scramble = scrambleAVX2;
+            }
+#endif
+        }
+    };
+
+    const XXH3Kernel &xxh3Kernel()
+    {
+        static XXH3Kernel kernel;
+        return kernel;
+    }
+
+    uint64_t mergeAccs(const uint64_t *acc, const unsigned char *secret, uint64_t start)
+    {
+        uint64_t result = start;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            result += mul128Fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+        }
+        return xxh3Avalanche(result);
+    }
+
+    uint64_t xxh3Long(const unsigned char *input, size_t length, const unsigned char *secret)
+    {
+        const XXH3Kernel &kernel = xxh3Kernel();
+
+        uint64_t acc[8];
+        memcpy(acc, INITIAL_ACC, sizeof(acc));
+
+        const size_t blockLen = STRIPE_LEN * STRIPES_PER_BLOCK;
+        size_t blocks = (length - 1) / blockLen;
+        for (size_t i = 0; i < blocks; ++i)
+        {
+            kernel.accumulate(acc, input + i * blockLen, secret, STRIPES_PER_BLOCK);
+            kernel.scramble(acc, secret + SECRET_SIZE - STRIPE_LEN);
+        }
+
+        size_t stripes = ((length - 1) - blockLen * blocks) / STRIPE_LEN;
+        kernel.accumulate(acc, input + blocks * blockLen, secret, stripes);
+        kernel.accumulate(acc, input + length - STRIPE_LEN, secret + SECRET_SIZE - STRIPE_LEN - SECRET_LASTACC_START, 1);
+
+        return mergeAccs(acc, secret + SECRET_MERGEACCS_START, length * PRIME64_1);
+    }
+
+    void initSecret(unsigned char *secret, uint64_t seed)
+    {
+        for (size_t i = 0; i < SECRET_SIZE / 16; ++i)
+        {
+            uint64_t lo = read64(DEFAULT_SECRET + 16 * i) + seed;
+            uint64_t hi = read64(DEFAULT_SECRET + 16 * i + 8) - seed;
+            memcpy(secret + 16 * i, &lo, 8);
+            memcpy(secret + 16 * i + 8, &hi, 8);
+        }
+    }
+
+    /**
+     * @brief 流式累加, 跨块边界时扰乱累加器, 返回当前块内已累加的条带数
+     */
+    size_t consumeStripes(uint64_t *acc, size_t stripes, size_t stripesAcc, const unsigned char *input, const unsigned char *secret)
+    {
+        const XXH3Kernel &kernel = xxh3Kernel();
+        if (STRIPES_PER_BLOCK - stripesAcc <= stripes)
+        {
+            size_t toEnd = STRIPES_PER_BLOCK - stripesAcc;
+            size_t afterEnd = stripes - toEnd;
+            kernel.accumulate(acc, input, secret + stripesAcc * SECRET_CONSUME_RATE, toEnd);
+            kernel.scramble(acc, secret + SECRET_SIZE - STRIPE_LEN);
+            kernel.accumulate(acc, input + toEnd * STRIPE_LEN, secret, afterEnd);
+            return afterEnd;
+        }
+
+        kernel.accumulate(acc, input, secret + stripesAcc * SECRET_CONSUME_RATE, stripes);
+        return stripesAcc + stripes;
+    }
+}
+
+SZ_XXH3::SZ_XXH3(uint64_t seed)
+{
+    reset(seed);
+}
+
+void SZ_XXH3::reset(uint64_t seed)
+{
+    memcpy(acc_, INITIAL_ACC, sizeof(acc_));
+    if (seed == 0)
+    {
+        memcpy(secret_, DEFAULT_SECRET, sizeof(secret_));
+    }
+    else
+    {
+        initSecret(secret_, seed);
+    }
+    buffered_ = 0;
+    stripes_ = 0;
+    total_ = 0;
+    seed_ = seed;
+}
+
+SZ_XXH3 &SZ_XXH3::update(const void *buffer, size_t length)
+{
+    const unsigned char *input = static_cast<const unsigned char *>(buffer);
+    total_ += length;
+
+    if (buffered_ + length <= INTERNAL_BUFFER_SIZE)
+    {
+        if (length > 0)
+        {
+            memcpy(buffer_ + buffered_, input, length);
+            buffered_ += length;
+        }
+        return *this;
+    }
+
+    const size_t bufferStripes = INTERNAL_BUFFER_SIZE / STRIPE_LEN;
+    if (buffered_ > 0)
+    {
+        size_t fill = INTERNAL_BUFFER_SIZE - buffered_;
+        memcpy(buffer_ + buffered_, input, fill);
+        input += fill;
+        length -= fill;
+        stripes_ = consumeStripes(acc_, bufferStripes, stripes_, buffer_, secret_);
+        buffered_ = 0;
+    }
+
+    // 最后一块总是留在缓冲中, digest时需要它作为最后一个条带
+    if (length > INTERNAL_BUFFER_SIZE)
+    {
+        do
+        {
+            stripes_ = consumeStripes(acc_, bufferStripes, stripes_, input, secret_);
+            input += INTERNAL_BUFFER_SIZE;
+            length -= INTERNAL_BUFFER_SIZE;
+        } while (length > INTERNAL_BUFFER_SIZE);
+        memcpy(buffer_ + INTERNAL_BUFFER_SIZE - STRIPE_LEN, input - STRIPE_LEN, STRIPE_LEN);
+    }
+
+    memcpy(buffer_, input, length);
+    buffered_ = length;
+
+    return *this;
+}
+
+SZ_XXH3 &SZ_XXH3::update(const std::string &buffer)
+{
+    return update(buffer.data(), buffer.size());
+}
+
+uint64_t SZ_XXH3::digest() const
+{
+    if (total_ <= MID_SIZE_MAX)
+    {
+        return hash(buffer_, static_cast<size_t>(total_), seed_);
+    }
+
+    const XXH3Kernel &kernel = xxh3Kernel();
+
+    uint64_t acc[8];
+    memcpy(acc, acc_, sizeof(acc));
+
+    const unsigned char *lastSecret = secret_ + SECRET_SIZE - STRIPE_LEN - SECRET_LASTACC_START;
+    if (buffered_ >= STRIPE_LEN)
+    {
+        size_t stripes = (buffered_ - 1) / STRIPE_LEN;
+        consumeStripes(acc, stripes, stripes_, buffer_, secret_);
+        kernel.accumulate(acc, buffer_ + buffered_ - STRIPE_LEN, lastSecret, 1);
+    }
+    else
+    {
+        // 不足一个条带时用上一块的尾部补齐
+        unsigned char lastStripe[STRIPE_LEN];
+        size_t catchup = STRIPE_LEN - buffered_;
+        memcpy(lastStripe, buffer_ + INTERNAL_BUFFER_SIZE - catchup, catchup);
+        memcpy(lastStripe + catchup, buffer_, buffered_);
+        kernel.accumulate(acc, lastStripe, lastSecret, 1);
+    }
+
+    return mergeAccs(acc, secret_ + SECRET_MERGEACCS_START, total_ * PRIME64_1);
+}
+
+uint64_t SZ_XXH3::hash(const void *buffer, size_t length, uint64_t seed)
+{
+    const unsigned char *input = static_cast<const unsigned char *>(buffer);
+    const unsigned char *secret = DEFAULT_SECRET;
+
+    if (length <= 16)
+    {
+        if (length > 8)
+        {
+            return xxh3Len9To16(input, length, secret, seed);
+        }
+        if (length >= 4)
+        {
+            return xxh3Len4To8(input, length, secret, seed);
+        }
+        if (length > 0)
+        {
+            return xxh3Len1To3(input, length, secret, seed);
+        }
+        return xxh64Avalanche(seed ^ (read64(secret + 56) ^ read64(secret + 64)));
+    }
+    if (length <= 128)
+    {
+        return xxh3Len17To128(input, length, secret, seed);
+    }
+    if (length <= MID_SIZE_MAX)
+    {
+        return xxh3Len129To240(input, length, secret, seed);
+    }
+
+    if (seed == 0)
+    {
+        return xxh3Long(input, length, DEFAULT_SECRET);
+    }
+
+    unsigned char custom[SECRET_SIZE];
+    initSecret(custom, seed);
+    return xxh3Long(input, length, custom);
+}
+
+uint64_t SZ_XXH3::hash(const std::string &buffer, uint64_t seed)
+{
+    return hash(buffer.data(), buffer.size(), seed);
+}
+
+uint64_t SZ_XXH3::hashFile(const std::string &fileName, uint64_t seed)
+{
+    SZ_XXH3 hasher(seed);
+    readFile(fileName, [&hasher](const unsigned char *data, size_t length)
+             { hasher.update(data, length); });
+
+    return hasher.digest();
+}
+
+/************************************************************************************************
+ * CRC32C
+ ************************************************************************************************/
+
+namespace
+{
+    /**
+     * @brief slicing-by-8查表, 多项式0x82F63B78(反射)
+     */
+    struct CRC32CTable
+    {
+        uint32_t table[8][256];
+
+        CRC32CTable()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int k = 0; k < 8; ++k)
+                {
+                    crc = (crc >> 1) ^ (0x82F63B78U & (0U - (crc & 1)));
+                }
+                table[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                for (int k = 1; k < 8; ++k)
+                {
+                    table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+
+    uint32_t crc32cSoftware(uint32_t crc, const unsigned char *data, size_t length)
+    {
+        static const CRC32CTable t;
+
+        while (length > 0 && (reinterpret_cast<uintptr_t>(data) & 7) != 0)
+        {
+            crc = (crc >> 8) ^ t.table[0][(crc ^ *data++) & 0xFF];
+            --length;
+        }
+        while (length >= 8)
+        {
+            uint64_t v = read64(data) ^ crc;
+            crc = t.table[7][v & 0xFF] ^ t.table[6][(v >> 8) & 0xFF] ^ t.table[5][(v >> 16) & 0xFF] ^ t.table[4][(v >> 24) & 0xFF] ^
+                  t.table[3][(v >> 32) & 0xFF] ^ t.table[2][(v >> 40) & 0xFF] ^ t.table[1][(v >> 48) & 0xFF] ^ t.table[0][v >> 56];
+            data += 8;
+            length -= 8;
+        }
+        while (length-- > 0)
+        {
+            crc = (crc >> 8) ^ t.table[0][(crc ^ *data++) & 0xFF];
+        }
+        return crc;
+    }
+
+#if defined SZ_HASH_X86 && defined __x86_64__
+    __attribute__((target("sse4.2"))) uint32_t crc32cHardware(uint32_t crc, const unsigned char *data, size_t length)
+    {
+        uint64_t crc64 = crc;
+        while (length >= 8)
+        {
+            crc64 = _mm_crc32_u64(crc64, read64(data));
+            data += 8;
+            length -= 8;
+        }
+        crc = static_cast<uint32_t>(crc64);
+        while (length-- > 0)
+        {
+            crc = _mm_crc32_u8(crc, *data++);
+        }
+        return crc;
+    }
+#endif
+
+    typedef uint32_t (*CRC32CFunc)(uint32_t, const unsigned char *, size_t);
+
+    CRC32CFunc crc32cFunc()
+    {
+        static CRC32CFunc func = []() -> CRC32CFunc
+        {
+#if defined SZ_HASH_X86 && defined __x86_64__
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse4.2"))
+            {
+                return crc32cHardware;
+            }
+#endif
+            return crc32cSoftware;
+        }();
+        return func;
+    }
+}
+
+SZ_CRC32C::SZ_CRC32C()
+{
+    reset();
+}
+
+void SZ_CRC32C::reset()
+{
+    state_ = 0xFFFFFFFFU;
+}
+
+SZ_CRC32C &SZ_CRC32C::update(const void *buffer, size_t length)
+{
+    state_ = crc32cFunc()(state_, static_cast<const unsigned char *>(buffer), length);
+    return *this;
+}
+
+SZ_CRC32C &SZ_CRC32C::update(const std::string &buffer)
+{
+    return update(buffer.data(), buffer.size());
+}
+
+uint32_t SZ_CRC32C::value() const
+{
+    return ~state_;
+}
+
+uint32_t SZ_CRC32C::checksum(const void *buffer, size_t length, uint32_t crc)
+{
+    return ~crc32cFunc()(~crc, static_cast<const unsigned char *>(buffer), length);
+}
+
+uint32_t SZ_CRC32C::checksum(const std::string &buffer, uint32_t crc)
+{
+    return checksum(buffer.data(), buffer.size(), crc);
+}
+
+uint32_t SZ_CRC32C::checksumFile(const std::string &fileName)
+{
+    SZ_CRC32C crc;
+    readFile(fileName, [&crc](const unsigned char *data, size_t length)
+             { crc.update(data, length); });
+
+    return crc.value();
+}
+
+bool SZ_CRC32C::hardware()
+{
+    return crc32cFunc() != crc32cSoftware;
+}
+
+/************************************************************************************************
+ * SHA-256
+ ************************************************************************************************/
+
+namespace
+{
+    const uint32_t SHA256_K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    void sha256Software(uint32_t state[8], const unsigned char *data, size_t blocks)
+    {
+        uint32_t w[64];
+        for (size_t n = 0; n < blocks; ++n, data += 64)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                w[i] = swap32(read32(data + 4 * i));
+            }
+            for (int i = 16; i < 64; ++i)
+            {
+                uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i)
+            {
+                uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+                uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+    }
+
+#if defined SZ_HASH_X86
+    __attribute__((target("sha,sse4.1"))) void sha256Hardware(uint32_t state[8], const unsigned char *data, size_t blocks)
+    {
+        const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+        // 状态重排为指令要求的ABEF/CDGH
+        __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0xB1);
+        __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4)), 0x1B);
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+        for (size_t n = 0; n < blocks; ++n, data += 64)
+        {
+            __m128i abefSave = state0;
+            __m128i cdghSave = state1;
+
+            __m128i msgs[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                msgs[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i)), MASK);
+            }
+
+            // 每轮4步, 同时为后续轮次扩展消息
+            for (int g = 0; g < 16; ++g)
+            {
+                __m128i &cur = msgs[g & 3];
+                __m128i msg = _mm_add_epi32(cur, _mm_loadu_si128(reinterpret_cast<const __m128i *>(SHA256_K + 4 * g)));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+                if (g >= 3 && g < 15)
+                {
+                    __m128i &next = msgs[(g + 1) & 3];
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(cur, msgs[(g + 3) & 3], 4));
+                    next = _mm_sha256msg2_epu32(next, cur);
+                }
+                msg = _mm_shuffle_epi32(msg, 0x0E);
+                state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+                if (g >= 1 && g < 13)
+                {
+                    __m128i &prev = msgs[(g + 3) & 3];
+                    prev = _mm_sha256msg1_epu32(prev, cur);
+                }
+            }
+
+            state0 = _mm_add_epi32(state0, abefSave);
+            state1 = _mm_add_epi32(state1, cdghSave);
+        }
+
+        tmp = _mm_shuffle_epi32(state0, 0x1B);
+        state1 = _mm_shuffle_epi32(state1, 0xB1);
+        state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+        state1 = _mm_alignr_epi8(state1, tmp, 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(state), state0);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), state1);
+    }
+#endif // SZ_HASH_X86
+
+    typedef void (*SHA256Func)(uint32_t *, const unsigned char *, size_t);
+
+    SHA256Func sha256Func()
+    {
+        static SHA256Func func = []() -> SHA256Func
+        {
+#if defined SZ_HASH_X86
+            unsigned int eax, ebx, ecx, edx;
+            if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_1) &&
+                __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1U << 29)))
+            {
+                return sha256Hardware;
+            }
+#endif
+            return sha256Software;
+        }();
+        return func;
+    }
+}
+
+SZ_SHA256::SZ_SHA256()
+{
+    reset();
+}
+
+void SZ_SHA256::reset()
+{
+    static const uint32_t INIT[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(state_, INIT, sizeof(state_));
+    total_ = 0;
+}
+
+SZ_SHA256 &SZ_SHA256::update(const void *buffer, size_t length)
+{
+    const unsigned char *input = static_cast<const unsigned char *>(buffer);
+    size_t used = static_cast<size_t>(total_ & 63);
+    total_ += length;
+
+    if (used > 0)
+    {
+        size_t fill = 64 - used;
+        if (length < fill)
+        {
+            memcpy(buffer_ + used, input, length);
+            return *this;
+        }
+        memcpy(buffer_ + used, input, fill);
+        sha256Func()(state_, buffer_, 1);
+        input += fill;
+        length -= fill;
+    }
+
+    if (length >= 64)
+    {
+        sha256Func()(state_, input, length / 64);
+        input += length & ~static_cast<size_t>(63);
+        length &= 63;
+    }
+
+    if (length > 0)
+    {
+        memcpy(buffer_, input, length);
+    }
+
+    return *this;
+}
+
+SZ_SHA256 &SZ_SHA256::update(const std::string &buffer)
+{
+    return update(buffer.data(), buffer.size());
+}
+
+void SZ_SHA256::finalize(unsigned char digest[32])
+{
+    uint64_t bits = total_ * 8;
+
+    unsigned char padding[128] = {0x80};
+    size_t used = static_cast<size_t>(total_ & 63);
+    size_t padLen = used < 56 ? 56 - used : 120 - used;
+    for (int i = 0; i < 8; ++i)
+    {
+        padding[padLen + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    }
+    update(padding, padLen + 8);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        uint32_t v = swap32(state_[i]);
+        memcpy(digest + 4 * i, &v, 4);
+    }
+}
+
+std::string SZ_SHA256::finalizeStr()
+{
+    unsigned char digest[32];
+    finalize(digest);
+
+    std::string str(sizeof(digest) * 2, '\0');
+    SZ_MD5::hexEncode(digest, sizeof(digest), &str[0]);
+    return str;
+}
+
+std::vector<char> SZ_SHA256::sha256bin(const char *buffer, size_t length)
+{
+    std::vector<char> vDigest(32);
+
+    SZ_SHA256 hasher;
+    hasher.update(buffer, length);
+    hasher.finalize(reinterpret_cast<unsigned char *>(vDigest.data()));
+
+    return vDigest;
+}
+
+std::vector<char> SZ_SHA256::sha256bin(const std::string &buffer)
+{
+    return sha256bin(buffer.data(), buffer.size());
+}
+
+std::string SZ_SHA256::sha256str(const char *buffer, size_t length)
+{
+    SZ_SHA256 hasher;
+    hasher.update(buffer, length);
+    return hasher.finalizeStr();
+}
+
+std::string SZ_SHA256::sha256str(const std::string &buffer)
+{
+    return sha256str(buffer.data(), buffer.size());
+}
+
+std::string SZ_SHA256::sha256file(const std::string &fileName)
+{
+    SZ_SHA256 hasher;
+    readFile(fileName, [&hasher](const unsigned char *data, size_t length)
+             { hasher.update(data, length); });
+
+    return hasher.finalizeStr();
+}
+
+bool SZ_SHA256::hardware()
+{
+    return sha256Func() != sha256Software;
+}
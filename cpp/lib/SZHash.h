@@ -0,0 +1,268 @@
+#pragma once
+
+#include "SZCommon.h"
+#include "SZUtility.h"
+
+#include <string>
+#include <vector>
+
+struct SZ_Hash_Exception : public SZ_Exception
+{
+    SZ_Hash_Exception(const std::string &sErr) : SZ_Exception(__FUNCTION__, sErr) {}
+    virtual ~SZ_Hash_Exception() noexcept {}
+};
+
+/**
+ * @brief XXH3 64位非加密哈希, 与官方xxHash v0.8 XXH3_64bits结果一致
+ *        适合哈希表、分片等场景, 速度远高于MD5, 不可用于安全校验
+ *        长输入在支持AVX2的CPU上使用向量累加
+ */
+class SZ_XXH3
+{
+public:
+    explicit SZ_XXH3(uint64_t seed = 0);
+
+    /**
+     * @brief 重置为初始状态
+     *
+     * @param seed
+     */
+    void reset(uint64_t seed = 0);
+
+    /**
+     * @brief 追加数据
+     *
+     * @param buffer
+     * @param length
+     * @return SZ_XXH3&
+     */
+    SZ_XXH3 &update(const void *buffer, size_t length);
+
+    /**
+     * @brief 追加数据
+     *
+     * @param buffer
+     * @return SZ_XXH3&
+     */
+    SZ_XXH3 &update(const std::string &buffer);
+
+    /**
+     * @brief 当前摘要, 不影响状态, 可继续追加
+     *
+     * @return uint64_t
+     */
+    uint64_t digest() const;
+
+    /**
+     * @brief 计算缓冲区
+     *
+     * @param buffer
+     * @param length
+     * @param seed
+     * @return uint64_t
+     */
+    static uint64_t hash(const void *buffer, size_t length, uint64_t seed = 0);
+
+    /**
+     * @brief 计算字符串
+     *
+     * @param buffer
+     * @param seed
+     * @return uint64_t
+     */
+    static uint64_t hash(const std::string &buffer, uint64_t seed = 0);
+
+    /**
+     * @brief 计算文件
+     *
+     * @param fileName
+     * @param seed
+     * @return uint64_t
+     */
+    static uint64_t hashFile(const std::string &fileName, uint64_t seed = 0);
+
+private:
+    uint64_t acc_[8];
+    unsigned char secret_[192];
+    unsigned char buffer_[256];
+    size_t buffered_;
+    size_t stripes_;
+    uint64_t total_;
+    uint64_t seed_;
+};
+
+/**
+ * @brief CRC32C(Castagnoli)校验和, 与iSCSI/ext4/RocksDB一致
+ *        支持SSE4.2的CPU上使用crc32指令, 否则查表计算
+ */
+class SZ_CRC32C
+{
+public:
+    SZ_CRC32C();
+
+    /**
+     * @brief 重置为初始状态
+     */
+    void reset();
+
+    /**
+     * @brief 追加数据
+     *
+     * @param buffer
+     * @param length
+     * @return SZ_CRC32C&
+     */
+    SZ_CRC32C &update(const void *buffer, size_t length);
+
+    /**
+     * @brief 追加数据
+     *
+     * @param buffer
+     * @return SZ_CRC32C&
+     */
+    SZ_CRC32C &update(const std::string &buffer);
+
+    /**
+     * @brief 当前校验和, 不影响状态, 可继续追加
+     *
+     * @return uint32_t
+     */
+    uint32_t value() const;
+
+    /**
+     * @brief 计算缓冲区, 可传入前一段的结果继续计算
+     *
+     * @param buffer
+     * @param length
+     * @param crc
+     * @return uint32_t
+     */
+    static uint32_t checksum(const void *buffer, size_t length, uint32_t crc = 0);
+
+    /**
+     * @brief 计算字符串
+     *
+     * @param buffer
+     * @param crc
+     * @return uint32_t
+     */
+    static uint32_t checksum(const std::string &buffer, uint32_t crc = 0);
+
+    /**
+     * @brief 计算文件
+     *
+     * @param fileName
+     * @return uint32_t
+     */
+    static uint32_t checksumFile(const std::string &fileName);
+
+    /**
+     * @brief 是否使用硬件指令
+     *
+     * @return bool
+     */
+    static bool hardware();
+
+private:
+    uint32_t state_;
+};
+
+/**
+ * @brief SHA-256, 支持SHA-NI的CPU上使用硬件指令, 否则软件计算
+ *        可拷贝, 拷贝后两份状态各自继续计算
+ */
+class SZ_SHA256
+{
+public:
+    SZ_SHA256();
+
+    /**
+     * @brief 重置为初始状态
+     */
+    void reset();
+
+    /**
+     * @brief 追加数据
+     *
+     * @param buffer
+     * @param length
+     * @return SZ_SHA256&
+     */
+    SZ_SHA256 &update(const void *buffer, size_t length);
+
+    /**
+     * @brief 追加数据
+     *
+     * @param buffer
+     * @return SZ_SHA256&
+     */
+    SZ_SHA256 &update(const std::string &buffer);
+
+    /**
+     * @brief 输出32字节摘要, 之后需reset才能复用
+     *
+     * @param digest
+     */
+    void finalize(unsigned char digest[32]);
+
+    /**
+     * @brief 输出64位十六进制摘要, 之后需reset才能复用
+     *
+     * @return std::string
+     */
+    std::string finalizeStr();
+
+    /**
+     * @brief 32位二进制数
+     *
+     * @param buffer
+     * @param length
+     * @return std::vector<char>
+     */
+    static std::vector<char> sha256bin(const char *buffer, size_t length);
+
+    /**
+     * @brief 32位二进制数
+     *
+     * @param buffer
+     * @return std::vector<char>
+     */
+    static std::vector<char> sha256bin(const std::string &buffer);
+
+    /**
+     * @brief 64位十六进制数
+     *
+     * @param buffer
+     * @param length
+     * @return std::string
+     */
+    static std::string sha256str(const char *buffer, size_t length);
+
+    /**
+     * @brief 64位十六进制数
+     *
+     * @param buffer
+     * @return std::string
+     */
+    static std::string sha256str(const std::string &buffer);
+
+    /**
+     * @brief 64位十六进制数
+     *
+     * @param fileName
+     * @return std::string
+     */
+    static std::string sha256file(const std::string &fileName);
+
+    /**
+     * @brief 是否使用硬件指令
+     *
+     * @return bool
+     */
+    static bool hardware();
+
+private:
+    uint32_t state_[8];
+    unsigned char buffer_[64];
+    uint64_t total_;
+};
@@ -1,5 +1,14 @@
 #include "SZMD5.h"
 
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+#include <sys/mman.h>
+#endif
+
 #ifndef SZ_MD5_GET_ULONG_LE
 #define SZ_MD5_GET_ULONG_LE(n, b, i)                                                                                                                      \
     {                                                                                                                                                     \
@@ -19,6 +28,38 @@
 
 #define SZ_MD5_ROTATE_LEFT(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
 
+// 每个字节对应的两个十六进制字符
+static const char SZ_MD5_HEX_PAIRS[513] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+// 十六进制字符对应的值, 非法字符为-1
+static const signed char SZ_MD5_HEX_VALUES[256] =
+    {
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+         0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+        -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
 unsigned char SZ_MD5::PADDING_[64] =
     {
         0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -159,29 +200,182 @@ void SZ_MD5::md5process(MD5_CTX *context, const unsigned char data[64])
 }
 
 std::string SZ_MD5::md5file(const std::string &filename)
+{
+    return md5file(filename, IO_AUTO);
+}
+
+std::string SZ_MD5::md5file(const std::string &filename, IOStrategy strategy)
 {
     unsigned char sOutBuffer[16];
+    MD5_CTX context;
+    md5init(&context);
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+    if (strategy == IO_STDIO)
+    {
+        md5fileStdio(&context, filename);
+    }
+    else
+    {
+        int fd = -1;
+        if (strategy == IO_DIRECT)
+        {
+            fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        }
+        if (fd < 0)
+        {
+            fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if (fd < 0)
+        {
+            throw SZ_MD5_Exception("Can not open file \"" + filename + "\"");
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            throw SZ_MD5_Exception("Can not stat file \"" + filename + "\"");
+        }
+
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        if (strategy == IO_AUTO)
+        {
+            // 不自动选择mmap: 读取期间文件被截断(日志轮转, 并发写入)时mmap会使进程收到SIGBUS, read只会提前读到文件尾
+            strategy = (size < BUFFER_THRESHOLD || !S_ISREG(st.st_mode)) ? IO_STDIO : IO_BUFFER;
+        }
+
+        try
+        {
+            if (strategy == IO_MMAP && S_ISREG(st.st_mode))
+            {
+                md5fileMmap(&context, fd, size, filename);
+            }
+            else
+            {
+                md5fileRead(&context, fd, filename, strategy);
+            }
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+#else
+    (void)strategy;
+    md5fileStdio(&context, filename);
+#endif
+
+    md5final(sOutBuffer, &context);
+
+    return binstr((const void *)sOutBuffer, sizeof(sOutBuffer), "");
+}
+
+void SZ_MD5::md5fileStdio(MD5_CTX *context, const std::string &filename)
+{
     unsigned char buf[16 * 1024];
     FILE *f;
     size_t n;
-    MD5_CTX context;
     if ((f = fopen(filename.c_str(), "rb")) == nullptr)
     {
         throw SZ_MD5_Exception("Can not open file \"" + filename + "\"");
     }
 
-    md5init(&context);
     while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
     {
-        md5update(&context, buf, (int)n);
+        md5update(context, buf, n);
     }
-    md5final(sOutBuffer, &context);
     fclose(f);
+}
 
-    return binstr((const void *)sOutBuffer, sizeof(sOutBuffer), "");
+void SZ_MD5::md5fileMmap(MD5_CTX *context, int fd, uint64_t size, const std::string &filename)
+{
+#if defined SZ_TARGET_PLATFORM_LINUX
+    if (size == 0)
+    {
+        return;
+    }
+
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        // 无法映射时退回read
+        md5fileRead(context, fd, filename, IO_BUFFER);
+        return;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    md5update(context, static_cast<const unsigned char *>(addr), size);
+    munmap(addr, size);
+#else
+    (void)context;
+    (void)fd;
+    (void)size;
+    (void)filename;
+#endif
+}
+
+void SZ_MD5::md5fileRead(MD5_CTX *context, int fd, const std::string &filename, IOStrategy strategy)
+{
+#if defined SZ_TARGET_PLATFORM_LINUX
+    // 小文件与非普通文件用栈上缓冲, 不值得分配大缓冲
+    unsigned char small[16 * 1024];
+    void *buf = small;
+    size_t bufSize = sizeof(small);
+    if (strategy == IO_BUFFER || strategy == IO_DIRECT)
+    {
+        if (posix_memalign(&buf, 4096, LARGE_BUFFER_SIZE) != 0)
+        {
+            throw SZ_MD5_Exception("Alloc read buffer failed for file \"" + filename + "\"");
+        }
+        bufSize = LARGE_BUFFER_SIZE;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    off_t offset = 0;
+    while (true)
+    {
+        ssize_t n = read(fd, buf, bufSize);
+        if (n > 0)
+        {
+            md5update(context, static_cast<const unsigned char *>(buf), static_cast<size_t>(n));
+
+            // 只有IO_DIRECT要求不经页缓存, O_DIRECT不可用退回普通read时, 丢弃已读完的部分
+            if (strategy == IO_DIRECT)
+            {
+                posix_fadvise(fd, offset, n, POSIX_FADV_DONTNEED);
+            }
+            offset += n;
+        }
+        else if (n == 0)
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            int err = errno;
+            if (buf != small)
+            {
+                free(buf);
+            }
+            throw SZ_MD5_Exception("Read file \"" + filename + "\" failed: " + strerror(err));
+        }
+    }
+    if (buf != small)
+    {
+        free(buf);
+    }
+#else
+    (void)context;
+    (void)fd;
+    (void)filename;
+    (void)strategy;
+#endif
 }
 
-void SZ_MD5::md5update(MD5_CTX *ctx, unsigned char *input, size_t ilen)
+void SZ_MD5::md5update(MD5_CTX *ctx, const unsigned char *input, size_t ilen)
 {
     unsigned int fill;
     unsigned long left;
@@ -189,13 +383,12 @@ void SZ_MD5::md5update(MD5_CTX *ctx, unsigned char *input, size_t ilen)
         return;
     left = ctx->count[0] & 0x3F;
     fill = 64 - left;
-    ctx->count[0] += ilen;
-    ctx->count[0] &= 0xFFFFFFFF;
-    if (ctx->count[0] < (unsigned long)ilen)
-        ctx->count[1]++;
+    uint64_t total = ((static_cast<uint64_t>(ctx->count[1]) << 32) | ctx->count[0]) + ilen;
+    ctx->count[0] = static_cast<uint32_t>(total);
+    ctx->count[1] = static_cast<uint32_t>(total >> 32);
     if (left && ilen >= fill)
     {
-        memcpy((void *)(ctx->buffer + left), (void *)input, fill);
+        memcpy((void *)(ctx->buffer + left), (const void *)input, fill);
         md5process(ctx, ctx->buffer);
         input += fill;
         ilen -= fill;
@@ -209,7 +402,7 @@ void SZ_MD5::md5update(MD5_CTX *ctx, unsigned char *input, size_t ilen)
     }
     if (ilen > 0)
     {
-        memcpy((void *)(ctx->buffer + left), (void *)input, ilen);
+        memcpy((void *)(ctx->buffer + left), (const void *)input, ilen);
     }
 }
 
@@ -297,8 +490,184 @@ std::string SZ_MD5::md5str(const std::string &buffer)
 
 std::string SZ_MD5::md5str(const char *buffer, size_t length)
 {
-    std::vector<char> s = md5bin(buffer, length);
-    return binstr((const void *)s.data(), s.size(), "");
+    return md5digest(buffer, length).str();
+}
+
+SZ_MD5Digest SZ_MD5::md5digest(const std::string &buffer)
+{
+    return md5digest(buffer.data(), buffer.size());
+}
+
+SZ_MD5Digest SZ_MD5::md5digest(const char *buffer, size_t length)
+{
+    SZ_MD5Digest digest;
+
+    MD5_CTX context;
+    md5init(&context);
+    md5update(&context, (const unsigned char *)buffer, length);
+    md5final(digest.bytes.data(), &context);
+
+    return digest;
+}
+
+void SZ_MD5::hexEncode(const void *data, size_t length, char *out)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < length; ++i)
+    {
+        memcpy(out + i * 2, SZ_MD5_HEX_PAIRS + p[i] * 2, 2);
+    }
+}
+
+bool SZ_MD5::hexDecode(const char *hex, size_t length, void *out)
+{
+    if (length % 2 != 0)
+    {
+        return false;
+    }
+
+    unsigned char *p = (unsigned char *)out;
+    for (size_t i = 0; i < length; i += 2)
+    {
+        int hi = SZ_MD5_HEX_VALUES[(unsigned char)hex[i]];
+        int lo = SZ_MD5_HEX_VALUES[(unsigned char)hex[i + 1]];
+        if ((hi | lo) < 0)
+        {
+            return false;
+        }
+        p[i / 2] = (unsigned char)((hi << 4) | lo);
+    }
+
+    return true;
+}
+
+static unsigned char *readBuffer(size_t size)
+{
+    static thread_local std::vector<unsigned char> vBuffer;
+    if (vBuffer.size() < size)
+    {
+        vBuffer.resize(size);
+    }
+    return vBuffer.data();
+}
+
+bool SZ_MD5::readFile(const std::string &fileName, const ReadCallback &callback, std::string &sErr, size_t bufferSize)
+{
+    bufferSize = bufferSize > 0 ? bufferSize : READ_BUFFER_SIZE;
+    unsigned char *buf = readBuffer(bufferSize);
+
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+    FILE *f = fopen(fileName.c_str(), "rb");
+    if (nullptr == f)
+    {
+        sErr = "Can not open file \"" + fileName + "\"";
+        return false;
+    }
+
+    size_t n;
+    while ((n = fread(buf, 1, bufferSize, f)) > 0)
+    {
+        callback(buf, n);
+    }
+    bool failed = ferror(f) != 0;
+    fclose(f);
+    if (failed)
+    {
+        sErr = "Read file \"" + fileName + "\" failed";
+        return false;
+    }
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        sErr = "Can not open file \"" + fileName + "\": " + strerror(errno);
+        return false;
+    }
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+    // 提示内核顺序预读, 计算当前块时下一块已在读取
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    while (true)
+    {
+        ssize_t n = ::read(fd, buf, bufferSize);
+        if (n > 0)
+        {
+            callback(buf, static_cast<size_t>(n));
+        }
+        else if (n == 0)
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            sErr = "Read file \"" + fileName + "\" failed: " + strerror(errno);
+            ::close(fd);
+            return false;
+        }
+    }
+    ::close(fd);
+#endif
+
+    return true;
+}
+
+bool SZ_MD5::readRange(int fd, const std::string &fileName, uint64_t offset, uint64_t length, const ReadCallback &callback, std::string &sErr)
+{
+    unsigned char *buf = readBuffer(READ_BUFFER_SIZE);
+
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+    (void)fd;
+    FILE *f = fopen(fileName.c_str(), "rb");
+    if (nullptr == f)
+    {
+        sErr = "Can not open file \"" + fileName + "\"";
+        return false;
+    }
+    if (_fseeki64(f, static_cast<int64_t>(offset), SEEK_SET) != 0)
+    {
+        fclose(f);
+        sErr = "Seek file \"" + fileName + "\" failed";
+        return false;
+    }
+    while (length > 0)
+    {
+        size_t n = fread(buf, 1, static_cast<size_t>(std::min<uint64_t>(length, static_cast<uint64_t>(READ_BUFFER_SIZE))), f);
+        if (n == 0)
+        {
+            fclose(f);
+            sErr = "Read file \"" + fileName + "\" failed";
+            return false;
+        }
+        callback(buf, n);
+        length -= n;
+    }
+    fclose(f);
+#else
+    while (length > 0)
+    {
+        ssize_t n = ::pread(fd, buf, static_cast<size_t>(std::min<uint64_t>(length, static_cast<uint64_t>(READ_BUFFER_SIZE))), static_cast<off_t>(offset));
+        if (n > 0)
+        {
+            callback(buf, static_cast<size_t>(n));
+            offset += static_cast<uint64_t>(n);
+            length -= static_cast<uint64_t>(n);
+        }
+        else if (n == 0)
+        {
+            sErr = "File \"" + fileName + "\" truncated while reading";
+            return false;
+        }
+        else if (errno != EINTR)
+        {
+            sErr = "Read file \"" + fileName + "\" failed: " + strerror(errno);
+            return false;
+        }
+    }
+#endif
+
+    return true;
 }
 
 std::string SZ_MD5::binstr(const void *buf, size_t length, const std::string &split)
@@ -308,15 +677,100 @@ std::string SZ_MD5::binstr(const void *buf, size_t length, const std::string &sp
         return "";
     }
 
-    std::string sOut;
-    char sBuf[255];
-    const char *p = (const char *)buf;
+    std::string sOut(length * (2 + split.size()), '\0');
+    if (split.empty())
+    {
+        hexEncode(buf, length, &sOut[0]);
+        return sOut;
+    }
 
-    for (size_t i = 0; i < length; ++i, ++p)
+    const unsigned char *p = (const unsigned char *)buf;
+    char *q = &sOut[0];
+    for (size_t i = 0; i < length; ++i)
     {
-        snprintf(sBuf, sizeof(sBuf), "%02x%s", (unsigned char)*p, split.c_str());
-        sOut += sBuf;
+        memcpy(q, SZ_MD5_HEX_PAIRS + p[i] * 2, 2);
+        memcpy(q + 2, split.data(), split.size());
+        q += 2 + split.size();
     }
 
     return sOut;
 }
+
+SZ_MD5Hasher::SZ_MD5Hasher()
+{
+    reset();
+}
+
+void SZ_MD5Hasher::reset()
+{
+    SZ_MD5::md5init(&context_);
+}
+
+SZ_MD5Hasher &SZ_MD5Hasher::update(const void *buffer, size_t length)
+{
+    SZ_MD5::md5update(&context_, static_cast<const unsigned char *>(buffer), length);
+    return *this;
+}
+
+SZ_MD5Hasher &SZ_MD5Hasher::update(const std::string &buffer)
+{
+    return update(buffer.data(), buffer.size());
+}
+
+void SZ_MD5Hasher::finalize(unsigned char digest[16])
+{
+    SZ_MD5::md5final(digest, &context_);
+}
+
+std::string SZ_MD5Hasher::finalizeStr()
+{
+    return finalizeDigest().str();
+}
+
+SZ_MD5Digest SZ_MD5Hasher::finalizeDigest()
+{
+    SZ_MD5Digest digest;
+    finalize(digest.bytes.data());
+    return digest;
+}
+
+uint64_t SZ_MD5Hasher::length() const
+{
+    return (static_cast<uint64_t>(context_.count[1]) << 32) | context_.count[0];
+}
+
+void SZ_MD5Digest::hex(char out[32]) const
+{
+    SZ_MD5::hexEncode(bytes.data(), bytes.size(), out);
+}
+
+std::array<char, 32> SZ_MD5Digest::hex() const
+{
+    std::array<char, 32> out;
+    hex(out.data());
+    return out;
+}
+
+std::string SZ_MD5Digest::str() const
+{
+    std::string s(32, '\0');
+    hex(&s[0]);
+    return s;
+}
+
+bool SZ_MD5Digest::parse(const char *hex, size_t length, SZ_MD5Digest &digest)
+{
+    SZ_MD5Digest parsed;
+    if (length != 32 || !SZ_MD5::hexDecode(hex, length, parsed.bytes.data()))
+    {
+        return false;
+    }
+    digest = parsed;
+
+    return true;
+}
+
+bool SZ_MD5Digest::parse(const std::string &hex, SZ_MD5Digest &digest)
+{
+    return parse(hex.data(), hex.size(), digest);
+}
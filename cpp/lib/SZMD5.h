@@ -3,8 +3,10 @@
 #include "SZCommon.h"
 #include "SZUtility.h"
 
+#include <array>
 #include <fstream>
 #include <cstring>
+#include <functional>
 #include <vector>
 
 struct SZ_MD5_Exception : public SZ_Exception
@@ -13,8 +15,98 @@ struct SZ_MD5_Exception : public SZ_Exception
     virtual ~SZ_MD5_Exception() noexcept {}
 };
 
+/**
+ * @brief 16字节MD5摘要值类型
+ *        可比较, 可作为有序或无序容器的键, 格式化与解析均不分配堆内存
+ */
+struct SZ_MD5Digest
+{
+    std::array<unsigned char, 16> bytes;
+
+    SZ_MD5Digest() : bytes() {}
+
+    explicit SZ_MD5Digest(const unsigned char data[16])
+    {
+        memcpy(bytes.data(), data, bytes.size());
+    }
+
+    /**
+     * @brief 写入32个小写十六进制字符, 不追加'\0'
+     *
+     * @param out
+     */
+    void hex(char out[32]) const;
+
+    /**
+     * @brief 32个小写十六进制字符
+     *
+     * @return std::array<char, 32>
+     */
+    std::array<char, 32> hex() const;
+
+    /**
+     * @brief 32位十六进制数
+     *
+     * @return std::string
+     */
+    std::string str() const;
+
+    /**
+     * @brief 解析32位十六进制数, 大小写均可
+     *
+     * @param hex
+     * @param length
+     * @param digest
+     * @return bool 长度不为32或含非法字符时返回false
+     */
+    static bool parse(const char *hex, size_t length, SZ_MD5Digest &digest);
+
+    /**
+     * @brief 解析32位十六进制数, 大小写均可
+     *
+     * @param hex
+     * @param digest
+     * @return bool
+     */
+    static bool parse(const std::string &hex, SZ_MD5Digest &digest);
+
+    bool operator==(const SZ_MD5Digest &other) const
+    {
+        return memcmp(bytes.data(), other.bytes.data(), bytes.size()) == 0;
+    }
+
+    bool operator!=(const SZ_MD5Digest &other) const
+    {
+        return !(*this == other);
+    }
+
+    bool operator<(const SZ_MD5Digest &other) const
+    {
+        return memcmp(bytes.data(), other.bytes.data(), bytes.size()) < 0;
+    }
+};
+
+namespace std
+{
+    /**
+     * @brief 摘要本身已均匀分布, 直接取前8字节
+     */
+    template <>
+    struct hash<SZ_MD5Digest>
+    {
+        size_t operator()(const SZ_MD5Digest &digest) const
+        {
+            uint64_t v;
+            memcpy(&v, digest.bytes.data(), sizeof(v));
+            return static_cast<size_t>(v);
+        }
+    };
+}
+
 class SZ_MD5
 {
+    friend class SZ_MD5Hasher;
+
     struct MD5_CTX
     {
         uint32_t state[4];
@@ -23,6 +115,22 @@ class SZ_MD5
     };
 
 public:
+    /**
+     * @brief 文件读取方式
+     */
+    enum IOStrategy
+    {
+        IO_AUTO,   // 按文件大小选择IO_STDIO或IO_BUFFER, 不使用mmap
+        IO_STDIO,  // fread + 16KB缓冲
+        IO_MMAP,   // mmap + MADV_SEQUENTIAL, 只在显式指定时使用: 读取期间文件被截断时进程会收到SIGBUS
+        IO_BUFFER, // posix_fadvise + 对齐大缓冲read, 保留页缓存
+        IO_DIRECT, // O_DIRECT + 对齐大缓冲read, 绕过页缓存, 文件系统不支持时退回read并丢弃已读部分的页缓存
+    };
+
+    static constexpr uint64_t BUFFER_THRESHOLD = 1024 * 1024; // IO_AUTO时不小于此大小使用大缓冲read
+    static constexpr size_t LARGE_BUFFER_SIZE = 4 * 1024 * 1024;
+    static constexpr size_t READ_BUFFER_SIZE = 256 * 1024; // readFile与readRange的默认块大小
+
     /**
      * @brief 16位二进制数
      *
@@ -57,6 +165,71 @@ public:
      */
     static std::string md5str(const char *buffer, size_t length);
 
+    /**
+     * @brief 摘要值
+     *
+     * @param buffer
+     * @return SZ_MD5Digest
+     */
+    static SZ_MD5Digest md5digest(const std::string &buffer);
+
+    /**
+     * @brief 摘要值
+     *
+     * @param buffer
+     * @param length
+     * @return SZ_MD5Digest
+     */
+    static SZ_MD5Digest md5digest(const char *buffer, size_t length);
+
+    /**
+     * @brief 查表编码为小写十六进制, 写入length * 2个字符, 不追加'\0'
+     *
+     * @param data
+     * @param length
+     * @param out
+     */
+    static void hexEncode(const void *data, size_t length, char *out);
+
+    /**
+     * @brief 查表解码十六进制, 大小写均可, 写入length / 2个字节
+     *
+     * @param hex
+     * @param length 须为偶数
+     * @param out
+     * @return bool 长度为奇数或含非法字符时返回false
+     */
+    static bool hexDecode(const char *hex, size_t length, void *out);
+
+    /**
+     * @brief 分块读取的回调, 参数为本块数据与长度
+     */
+    typedef std::function<void(const unsigned char *data, size_t length)> ReadCallback;
+
+    /**
+     * @brief 顺序分块读取整个文件, 不抛异常, 每个线程复用同一块读缓冲
+     *
+     * @param fileName
+     * @param callback
+     * @param sErr 失败原因
+     * @param bufferSize 每块大小
+     * @return bool 打开或读取失败时返回false
+     */
+    static bool readFile(const std::string &fileName, const ReadCallback &callback, std::string &sErr, size_t bufferSize = READ_BUFFER_SIZE);
+
+    /**
+     * @brief 以pread分块读取已打开文件的[offset, offset + length), 不抛异常, 多线程可共用同一fd
+     *
+     * @param fd Windows下不使用, 按fileName重新打开
+     * @param fileName
+     * @param offset
+     * @param length
+     * @param callback
+     * @param sErr 失败原因, 含读到的长度不足length
+     * @return bool
+     */
+    static bool readRange(int fd, const std::string &fileName, uint64_t offset, uint64_t length, const ReadCallback &callback, std::string &sErr);
+
     /**
      * @brief 32位十六进制数
      *
@@ -65,6 +238,15 @@ public:
      */
     static std::string md5file(const std::string &fileName);
 
+    /**
+     * @brief 32位十六进制数
+     *
+     * @param fileName
+     * @param strategy 读取方式, 非Linux平台总是使用IO_STDIO; IO_MMAP要求读取期间文件不被截断, 否则进程收到SIGBUS
+     * @return std::string
+     */
+    static std::string md5file(const std::string &fileName, IOStrategy strategy);
+
 protected:
     /**
      * @brief 初始化
@@ -80,7 +262,7 @@ protected:
      * @param input
      * @param length
      */
-    static void md5update(MD5_CTX *context, unsigned char *input, size_t length);
+    static void md5update(MD5_CTX *context, const unsigned char *input, size_t length);
 
     /**
      * @brief 最终处理
@@ -134,6 +316,34 @@ protected:
      */
     static void md5memset(unsigned char *output, int value, size_t length);
 
+    /**
+     * @brief 以fread读取文件
+     *
+     * @param context
+     * @param fileName
+     */
+    static void md5fileStdio(MD5_CTX *context, const std::string &fileName);
+
+    /**
+     * @brief 以mmap读取文件
+     *
+     * @param context
+     * @param fd
+     * @param size
+     * @param fileName
+     */
+    static void md5fileMmap(MD5_CTX *context, int fd, uint64_t size, const std::string &fileName);
+
+    /**
+     * @brief 以read读取已打开的文件
+     *
+     * @param context
+     * @param fd
+     * @param fileName
+     * @param strategy IO_BUFFER与IO_DIRECT用对齐大缓冲, IO_DIRECT还会丢弃已读部分的页缓存, 其余用栈上16KB缓冲
+     */
+    static void md5fileRead(MD5_CTX *context, int fd, const std::string &fileName, IOStrategy strategy);
+
     /**
      * @brief 二进制串
      *
@@ -146,3 +356,67 @@ protected:
 
     static unsigned char PADDING_[64];
 };
+
+/**
+ * @brief 流式MD5, 数据可分块输入
+ *        可拷贝, 拷贝后两份状态各自继续计算
+ */
+class SZ_MD5Hasher
+{
+public:
+    SZ_MD5Hasher();
+
+    /**
+     * @brief 重置为初始状态
+     */
+    void reset();
+
+    /**
+     * @brief 追加数据
+     *
+     * @param buffer
+     * @param length
+     * @return SZ_MD5Hasher&
+     */
+    SZ_MD5Hasher &update(const void *buffer, size_t length);
+
+    /**
+     * @brief 追加数据
+     *
+     * @param buffer
+     * @return SZ_MD5Hasher&
+     */
+    SZ_MD5Hasher &update(const std::string &buffer);
+
+    /**
+     * @brief 输出16字节摘要, 之后需reset才能复用
+     *        需要保留中间状态时先拷贝再对副本调用
+     *
+     * @param digest
+     */
+    void finalize(unsigned char digest[16]);
+
+    /**
+     * @brief 输出32位十六进制摘要, 之后需reset才能复用
+     *
+     * @return std::string
+     */
+    std::string finalizeStr();
+
+    /**
+     * @brief 输出摘要值, 之后需reset才能复用
+     *
+     * @return SZ_MD5Digest
+     */
+    SZ_MD5Digest finalizeDigest();
+
+    /**
+     * @brief 已输入的字节数
+     *
+     * @return uint64_t
+     */
+    uint64_t length() const;
+
+private:
+    SZ_MD5::MD5_CTX context_;
+};
@@ -0,0 +1,192 @@
+#include "SZMD5Batch.h"
+
+#include <sys/stat.h>
+
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+#include <dirent.h>
+#endif
+
+SZ_MD5Batch::SZ_MD5Batch(size_t threads, size_t inflight, size_t bufferSize)
+    : inflight_(0), bufferSize_(bufferSize > 0 ? bufferSize : 64 * 1024), slots_(0)
+{
+    pool_.start(threads);
+    inflight_ = inflight > 0 ? inflight : pool_.pools() * 4;
+    slots_.post(static_cast<int32_t>(inflight_));
+}
+
+SZ_MD5Batch::~SZ_MD5Batch()
+{
+    drain();
+    pool_.stop();
+}
+
+void SZ_MD5Batch::hashFiles(const std::vector<std::string> &paths, const Callback &callback)
+{
+    Callback serial = serialize(callback);
+    for (auto &path : paths)
+    {
+        submit(path, serial);
+    }
+    drain();
+}
+
+void SZ_MD5Batch::hashDirectory(const std::string &dir, const Callback &callback, bool recursive)
+{
+    Callback serial = serialize(callback);
+    try
+    {
+        walk(dir, serial, recursive, true);
+    }
+    catch (...)
+    {
+        drain();
+        throw;
+    }
+    drain();
+}
+
+void SZ_MD5Batch::hashFiles(const std::vector<std::string> &paths, SZ_ThreadQueue<SZ_MD5FileResult> &queue)
+{
+    // 直接在工作线程上入队, 不经callbackMtx_: 队列满时只阻塞入队的工作线程, 不让其余线程空转
+    Callback push = [&queue](const SZ_MD5FileResult &result)
+    { queue.push(result, -1); };
+    for (auto &path : paths)
+    {
+        submit(path, push);
+    }
+    drain();
+}
+
+SZ_MD5FileResult SZ_MD5Batch::hashFile(const std::string &path, size_t bufferSize)
+{
+    SZ_MD5FileResult result;
+    result.path = path;
+
+    SZ_MD5Hasher hasher;
+    if (!SZ_MD5::readFile(path, [&hasher](const unsigned char *data, size_t length)
+                          { hasher.update(data, length); },
+                          result.error, bufferSize))
+    {
+        return result;
+    }
+
+    result.size = hasher.length();
+    result.md5 = hasher.finalizeStr();
+
+    return result;
+}
+
+void SZ_MD5Batch::submit(const std::string &path, const Callback &callback)
+{
+    size_t bufferSize = bufferSize_;
+    dispatch([path, bufferSize]()
+             { return hashFile(path, bufferSize); },
+             callback);
+}
+
+void SZ_MD5Batch::dispatch(const std::function<SZ_MD5FileResult()> &task, const Callback &callback)
+{
+    slots_.wait();
+
+    pool_.insert([this, task, &callback]()
+                 {
+                     SZ_MD5FileResult result = task();
+                     try
+                     {
+                         callback(result);
+                     }
+                     catch (...)
+                     {
+                         slots_.post();
+                         throw;
+                     }
+                     slots_.post(); });
+}
+
+SZ_MD5Batch::Callback SZ_MD5Batch::serialize(const Callback &callback)
+{
+    return [this, &callback](const SZ_MD5FileResult &result)
+    {
+        std::lock_guard<std::mutex> locker(callbackMtx_);
+        callback(result);
+    };
+}
+
+void SZ_MD5Batch::drain()
+{
+    // 收回全部名额即说明没有在途文件
+    for (size_t i = 0; i < inflight_; ++i)
+    {
+        slots_.wait();
+    }
+    slots_.post(static_cast<int32_t>(inflight_));
+}
+
+void SZ_MD5Batch::walk(const std::string &dir, const Callback &callback, bool recursive, bool isRoot)
+{
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+    (void)dir;
+    (void)callback;
+    (void)recursive;
+    (void)isRoot;
+    throw SZ_MD5_Exception("Directory hashing is not supported on this platform");
+#else
+    DIR *d = opendir(dir.c_str());
+    if (nullptr == d)
+    {
+        std::string sErr = "Can not open directory \"" + dir + "\": " + strerror(errno);
+        if (isRoot)
+        {
+            throw SZ_MD5_Exception(sErr);
+        }
+
+        // 与无法读取的文件一样在工作线程上报告, 不中断其余目录
+        dispatch([dir, sErr]()
+                 {
+                     SZ_MD5FileResult result;
+                     result.path = dir;
+                     result.error = sErr;
+                     return result; },
+                 callback);
+        return;
+    }
+
+    std::vector<std::string> vSubDirs;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != nullptr)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        std::string path = dir + "/" + entry->d_name;
+
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN)
+        {
+            struct stat st;
+            if (lstat(path.c_str(), &st) != 0)
+            {
+                continue;
+            }
+            type = S_ISREG(st.st_mode) ? DT_REG : (S_ISDIR(st.st_mode) ? DT_DIR : DT_UNKNOWN);
+        }
+
+        if (type == DT_REG)
+        {
+            submit(path, callback);
+        }
+        else if (type == DT_DIR && recursive)
+        {
+            vSubDirs.push_back(path);
+        }
+    }
+    closedir(d);
+
+    for (auto &sub : vSubDirs)
+    {
+        walk(sub, callback, recursive, false);
+    }
+#endif
+}
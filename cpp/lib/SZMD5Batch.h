@@ -0,0 +1,130 @@
+#pragma once
+
+#include "SZMD5.h"
+#include "SZThreadPool.h"
+#include "SZThreadQueue.h"
+#include "SZSemaphore.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 单个文件的计算结果
+ */
+struct SZ_MD5FileResult
+{
+    std::string path;
+    std::string md5;   // 32位十六进制, 失败时为空
+    std::string error; // 失败原因, 成功时为空
+    uint64_t size;
+
+    SZ_MD5FileResult() : size(0) {}
+};
+
+/**
+ * @brief 多文件并行MD5
+ *        文件分发到SZ_ThreadPool上计算, 在途文件数受限, 每个工作线程复用固定大小的读缓冲, 内存有界
+ *        目录边遍历边提交, 不预先生成完整文件列表
+ */
+class SZ_MD5Batch : public SZ_Uncopy
+{
+public:
+    typedef std::function<void(const SZ_MD5FileResult &)> Callback;
+
+public:
+    /**
+     * @brief
+     *
+     * @param threads 工作线程数, 为0时取CPU核数
+     * @param inflight 同时在途的文件数上限, 为0时取线程数的4倍
+     * @param bufferSize 每个工作线程的读缓冲大小
+     */
+    explicit SZ_MD5Batch(size_t threads = 0, size_t inflight = 0, size_t bufferSize = 256 * 1024);
+
+    ~SZ_MD5Batch();
+
+    /**
+     * @brief 计算一组文件, 全部完成后返回
+     *        回调在工作线程中串行调用
+     *
+     * @param paths
+     * @param callback
+     */
+    void hashFiles(const std::vector<std::string> &paths, const Callback &callback);
+
+    /**
+     * @brief 计算目录下所有普通文件, 全部完成后返回
+     *        dir本身无法打开时抛出异常, 无法打开的子目录与文件一样以带error的结果回调
+     *
+     * @param dir
+     * @param callback
+     * @param recursive 是否递归子目录
+     */
+    void hashDirectory(const std::string &dir, const Callback &callback, bool recursive = true);
+
+    /**
+     * @brief 计算一组文件, 结果写入队列, 队列满时工作线程阻塞等待消费
+     *        须在其他线程中同时消费队列, 否则结果数超过队列容量时永远不会返回
+     *
+     * @param paths
+     * @param queue
+     */
+    void hashFiles(const std::vector<std::string> &paths, SZ_ThreadQueue<SZ_MD5FileResult> &queue);
+
+    /**
+     * @brief 计算单个文件, 不抛异常
+     *
+     * @param path
+     * @param bufferSize
+     * @return SZ_MD5FileResult
+     */
+    static SZ_MD5FileResult hashFile(const std::string &path, size_t bufferSize = 256 * 1024);
+
+protected:
+    /**
+     * @brief 提交单个文件, 在途数达到上限时阻塞
+     *
+     * @param path
+     * @param callback 在工作线程中调用, 需要串行时先经serialize包装
+     */
+    void submit(const std::string &path, const Callback &callback);
+
+    /**
+     * @brief 在工作线程上执行task并以其结果回调, 在途数达到上限时阻塞
+     *
+     * @param task
+     * @param callback
+     */
+    void dispatch(const std::function<SZ_MD5FileResult()> &task, const Callback &callback);
+
+    /**
+     * @brief 包装为持有callbackMtx_调用的回调
+     *
+     * @param callback 须在返回的回调使用期间有效
+     * @return Callback
+     */
+    Callback serialize(const Callback &callback);
+
+    /**
+     * @brief 等待所有已提交的文件完成
+     */
+    void drain();
+
+    /**
+     * @brief 遍历目录并提交
+     *
+     * @param dir
+     * @param callback
+     * @param recursive
+     * @param isRoot 是否为hashDirectory传入的目录, 只有它无法打开时抛出异常
+     */
+    void walk(const std::string &dir, const Callback &callback, bool recursive, bool isRoot);
+
+private:
+    size_t inflight_;
+    size_t bufferSize_;
+    SZ_Semaphore slots_;
+    std::mutex callbackMtx_;
+    SZ_ThreadPool pool_;
+};
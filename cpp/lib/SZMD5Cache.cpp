@@ -0,0 +1,538 @@
+#include "SZMD5Cache.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+#include <sys/file.h>
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    const char INDEX_MAGIC[8] = {'S', 'Z', 'M', 'D', '5', 'I', 'D', 'X'};
+    const uint32_t INDEX_VERSION = 1;
+    const int64_t RACY_WINDOW_NS = 1000000000LL;
+    const int SEQ_RETRIES = 64; // 读到写入中的条目时的重试次数, 写入方中途退出时序号会一直为奇数
+
+    inline uint64_t mixKey(uint64_t dev, uint64_t ino)
+    {
+        uint64_t k = ino ^ (dev * 0x9E3779B97F4A7C15ULL);
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+    /**
+     * @brief 跨进程写锁
+     */
+    struct FileLock
+    {
+        int fd;
+
+        explicit FileLock(int f) : fd(f)
+        {
+            while (flock(fd, LOCK_EX) != 0)
+            {
+                if (errno != EINTR)
+                {
+                    throw SZ_MD5_Exception(std::string("Lock digest cache failed: ") + strerror(errno));
+                }
+            }
+        }
+
+        ~FileLock()
+        {
+            flock(fd, LOCK_UN);
+        }
+    };
+#endif
+}
+
+/**
+ * @brief 索引文件头, 64字节
+ */
+struct SZ_MD5Cache::Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t capacity; // 2的幂
+    uint64_t count;
+    uint32_t stale; // 已被新文件替换
+    char reserved[28];
+};
+
+/**
+ * @brief 索引条目, 64字节
+ *        seq为奇数时正在写入, 读取前后seq相同且为偶数才有效
+ */
+struct SZ_MD5Cache::Entry
+{
+    uint32_t seq;
+    uint32_t used;
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtimeNs;
+    unsigned char digest[16];
+    char reserved[8];
+};
+
+SZ_MD5Cache::SZ_MD5Cache(const std::string &indexFile, size_t capacity)
+    : indexFile_(indexFile), capacity_(16), lockFd_(-1), writable_(false), map_(nullptr), mapSize_(0), header_(nullptr), entries_(nullptr), hits_(0), misses_(0)
+{
+    static_assert(sizeof(Header) == 64, "digest cache header must be 64 bytes");
+    static_assert(sizeof(Entry) == 64, "digest cache entry must be 64 bytes");
+
+    while (capacity_ < capacity)
+    {
+        capacity_ <<= 1;
+    }
+
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+    throw SZ_MD5_Exception("Digest cache is not supported on this platform");
+#else
+    lockFd_ = ::open((indexFile_ + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFd_ >= 0)
+    {
+        FileLock locker(lockFd_);
+        remap(true);
+    }
+    else
+    {
+        // 无写权限时只读使用已有索引
+        remap(false);
+    }
+#endif
+}
+
+SZ_MD5Cache::~SZ_MD5Cache()
+{
+    unmap();
+    if (lockFd_ >= 0)
+    {
+        ::close(lockFd_);
+    }
+}
+
+std::string SZ_MD5Cache::md5file(const std::string &fileName)
+{
+    Key key;
+    if (!statKey(fileName, key))
+    {
+        ++misses_;
+        return SZ_MD5::md5file(fileName);
+    }
+
+    unsigned char digest[16];
+    {
+        std::lock_guard<std::mutex> locker(mapMtx_);
+        if (find(key, digest))
+        {
+            ++hits_;
+            return SZ_MD5Digest(digest).str();
+        }
+    }
+    ++misses_;
+
+    std::string md5 = SZ_MD5::md5file(fileName);
+
+    // 计算期间文件未变且不在时间粒度竞争窗口内才写入
+    Key after;
+    if (writable_ && statKey(fileName, after) && memcmp(&key, &after, sizeof(key)) == 0 && SZ_MD5::hexDecode(md5.data(), md5.size(), digest))
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        int64_t nowNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+        if (nowNs - key.mtimeNs >= RACY_WINDOW_NS)
+        {
+            std::lock_guard<std::mutex> locker(mapMtx_);
+            insert(key, digest);
+        }
+    }
+
+    return md5;
+}
+
+bool SZ_MD5Cache::lookup(const std::string &fileName, std::string &md5)
+{
+    Key key;
+    if (!statKey(fileName, key))
+    {
+        return false;
+    }
+
+    unsigned char digest[16];
+    std::lock_guard<std::mutex> locker(mapMtx_);
+    if (!find(key, digest))
+    {
+        return false;
+    }
+    md5 = SZ_MD5Digest(digest).str();
+
+    return true;
+}
+
+size_t SZ_MD5Cache::size()
+{
+    std::lock_guard<std::mutex> locker(mapMtx_);
+    if (__atomic_load_n(&header_->stale, __ATOMIC_ACQUIRE) != 0)
+    {
+        remap(false);
+    }
+
+    return static_cast<size_t>(__atomic_load_n(&header_->count, __ATOMIC_RELAXED));
+}
+
+void SZ_MD5Cache::clear()
+{
+    if (!writable_)
+    {
+        throw SZ_MD5_Exception("Digest cache \"" + indexFile_ + "\" is read only");
+    }
+
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+    std::lock_guard<std::mutex> locker(mapMtx_);
+    FileLock fileLocker(lockFd_);
+
+    std::string tmp = indexFile_ + ".tmp." + std::to_string(getpid());
+    createIndex(tmp, capacity_);
+    if (::rename(tmp.c_str(), indexFile_.c_str()) != 0)
+    {
+        ::unlink(tmp.c_str());
+        throw SZ_MD5_Exception("Replace digest cache \"" + indexFile_ + "\" failed: " + strerror(errno));
+    }
+    __atomic_store_n(&header_->stale, 1, __ATOMIC_RELEASE);
+    remap(false);
+#endif
+}
+
+uint64_t SZ_MD5Cache::hits() const
+{
+    return hits_.load(std::memory_order_relaxed);
+}
+
+uint64_t SZ_MD5Cache::misses() const
+{
+    return misses_.load(std::memory_order_relaxed);
+}
+
+bool SZ_MD5Cache::statKey(const std::string &fileName, Key &key)
+{
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+    (void)fileName;
+    (void)key;
+    return false;
+#else
+    struct stat st;
+    if (::stat(fileName.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.dev = static_cast<uint64_t>(st.st_dev);
+    key.ino = static_cast<uint64_t>(st.st_ino);
+    key.size = static_cast<uint64_t>(st.st_size);
+#if defined SZ_TARGET_PLATFORM_IOS
+    key.mtimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    key.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+
+    return true;
+#endif
+}
+
+bool SZ_MD5Cache::find(const Key &key, unsigned char digest[16])
+{
+    if (__atomic_load_n(&header_->stale, __ATOMIC_ACQUIRE) != 0)
+    {
+        remap(false);
+    }
+
+    uint64_t mask = header_->capacity - 1;
+    uint64_t slot = mixKey(key.dev, key.ino) & mask;
+    for (uint64_t i = 0; i <= mask; ++i, slot = (slot + 1) & mask)
+    {
+        Entry *entry = &entries_[slot];
+
+        Entry copy;
+        bool consistent = false;
+        for (int retry = 0; retry < SEQ_RETRIES; ++retry)
+        {
+            uint32_t before = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+            if (before & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            memcpy(&copy, entry, sizeof(copy));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&entry->seq, __ATOMIC_RELAXED) == before)
+            {
+                consistent = true;
+                break;
+            }
+        }
+
+        // 一直读不到完整条目时跳过, 要找的键可能在探测链后面; 该条目由之后经过的insert在文件锁下作废
+        if (!consistent)
+        {
+            continue;
+        }
+        if (!copy.used)
+        {
+            return false;
+        }
+        if (copy.dev == key.dev && copy.ino == key.ino)
+        {
+            if (copy.size != key.size || copy.mtimeNs != key.mtimeNs)
+            {
+                return false;
+            }
+            memcpy(digest, copy.digest, sizeof(copy.digest));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SZ_MD5Cache::insert(const Key &key, const unsigned char digest[16])
+{
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+    FileLock locker(lockFd_);
+    if (__atomic_load_n(&header_->stale, __ATOMIC_ACQUIRE) != 0)
+    {
+        remap(false);
+    }
+
+    if ((header_->count + 1) * 4 > header_->capacity * 3)
+    {
+        grow();
+    }
+
+    uint64_t mask = header_->capacity - 1;
+    uint64_t slot = mixKey(key.dev, key.ino) & mask;
+    Entry *entry = nullptr;
+    for (uint64_t i = 0; i <= mask; ++i, slot = (slot + 1) & mask)
+    {
+        Entry *e = &entries_[slot];
+        if (e->seq & 1)
+        {
+            repair(slot);
+        }
+        if (!e->used || (e->dev == key.dev && e->ino == key.ino))
+        {
+            entry = e;
+            break;
+        }
+    }
+    if (nullptr == entry)
+    {
+        return;
+    }
+
+    bool fresh = !entry->used;
+    uint32_t seq = entry->seq + 1;
+    __atomic_store_n(&entry->seq, seq, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    entry->dev = key.dev;
+    entry->ino = key.ino;
+    entry->size = key.size;
+    entry->mtimeNs = key.mtimeNs;
+    memcpy(entry->digest, digest, sizeof(entry->digest));
+    entry->used = 1;
+    __atomic_store_n(&entry->seq, seq + 1, __ATOMIC_RELEASE);
+
+    if (fresh)
+    {
+        __atomic_fetch_add(&header_->count, 1, __ATOMIC_RELAXED);
+    }
+#else
+    (void)key;
+    (void)digest;
+#endif
+}
+
+void SZ_MD5Cache::repair(uint64_t slot)
+{
+    Entry *entry = &entries_[slot];
+
+    // 持有文件锁时序号为奇数说明上次写入的进程中途退出, 内容可能新旧混杂
+    // 保留dev/ino使探测链不断, 大小与修改时间置为不可能的值, 查找该文件时按未命中处理, 再次写入时覆盖
+    entry->size = UINT64_MAX;
+    entry->mtimeNs = INT64_MIN;
+    memset(entry->digest, 0, sizeof(entry->digest));
+    __atomic_store_n(&entry->seq, entry->seq + 1, __ATOMIC_RELEASE);
+}
+
+void SZ_MD5Cache::remap(bool create)
+{
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+    unmap();
+
+    writable_ = lockFd_ >= 0;
+    int fd = ::open(indexFile_.c_str(), (writable_ ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (fd < 0 && writable_ && errno == EACCES)
+    {
+        writable_ = false;
+        fd = ::open(indexFile_.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    struct stat st;
+    bool valid = fd >= 0 && fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Header);
+    Header header;
+    if (valid)
+    {
+        valid = ::pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 && header.version == INDEX_VERSION &&
+                header.entrySize == sizeof(Entry) && header.capacity > 0 && (header.capacity & (header.capacity - 1)) == 0 &&
+                static_cast<uint64_t>(st.st_size) == sizeof(Header) + header.capacity * sizeof(Entry);
+    }
+
+    if (!valid)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        if (!create || !writable_)
+        {
+            throw SZ_MD5_Exception("Invalid digest cache \"" + indexFile_ + "\"");
+        }
+
+        // 不存在或已损坏, 新建后原子替换
+        std::string tmp = indexFile_ + ".tmp." + std::to_string(getpid());
+        createIndex(tmp, capacity_);
+        if (::rename(tmp.c_str(), indexFile_.c_str()) != 0)
+        {
+            ::unlink(tmp.c_str());
+            throw SZ_MD5_Exception("Create digest cache \"" + indexFile_ + "\" failed: " + strerror(errno));
+        }
+        remap(false);
+        return;
+    }
+
+    mapSize_ = static_cast<size_t>(st.st_size);
+    void *p = mmap(nullptr, mapSize_, writable_ ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        mapSize_ = 0;
+        throw SZ_MD5_Exception("Map digest cache \"" + indexFile_ + "\" failed: " + strerror(errno));
+    }
+
+    map_ = static_cast<char *>(p);
+    header_ = reinterpret_cast<Header *>(map_);
+    entries_ = reinterpret_cast<Entry *>(map_ + sizeof(Header));
+#else
+    (void)create;
+#endif
+}
+
+void SZ_MD5Cache::grow()
+{
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+    uint64_t capacity = header_->capacity * 2;
+    std::string tmp = indexFile_ + ".tmp." + std::to_string(getpid());
+    createIndex(tmp, capacity);
+
+    int fd = ::open(tmp.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw SZ_MD5_Exception("Open digest cache \"" + tmp + "\" failed: " + strerror(errno));
+    }
+    size_t size = sizeof(Header) + capacity * sizeof(Entry);
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        ::unlink(tmp.c_str());
+        throw SZ_MD5_Exception("Map digest cache \"" + tmp + "\" failed: " + strerror(errno));
+    }
+
+    // 新文件尚未对外可见, 无需序号保护
+    Header *header = static_cast<Header *>(p);
+    Entry *entries = reinterpret_cast<Entry *>(static_cast<char *>(p) + sizeof(Header));
+    uint64_t mask = capacity - 1;
+    for (uint64_t i = 0; i < header_->capacity; ++i)
+    {
+        // 序号为奇数的条目可能新旧混杂, 不复制, 代价只是再算一次
+        const Entry &old = entries_[i];
+        if (!old.used || (old.seq & 1))
+        {
+            continue;
+        }
+        uint64_t slot = mixKey(old.dev, old.ino) & mask;
+        while (entries[slot].used)
+        {
+            slot = (slot + 1) & mask;
+        }
+        entries[slot] = old;
+        entries[slot].seq = 0;
+        ++header->count;
+    }
+    munmap(p, size);
+
+    if (::rename(tmp.c_str(), indexFile_.c_str()) != 0)
+    {
+        ::unlink(tmp.c_str());
+        throw SZ_MD5_Exception("Replace digest cache \"" + indexFile_ + "\" failed: " + strerror(errno));
+    }
+    __atomic_store_n(&header_->stale, 1, __ATOMIC_RELEASE);
+    remap(false);
+#endif
+}
+
+void SZ_MD5Cache::createIndex(const std::string &path, uint64_t capacity)
+{
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw SZ_MD5_Exception("Create digest cache \"" + path + "\" failed: " + strerror(errno));
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.entrySize = sizeof(Entry);
+    header.capacity = capacity;
+
+    // ftruncate扩展的部分为0, 即全部条目为空
+    bool ok = ftruncate(fd, static_cast<off_t>(sizeof(Header) + capacity * sizeof(Entry))) == 0 &&
+              ::pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    int err = errno;
+    ::close(fd);
+    if (!ok)
+    {
+        ::unlink(path.c_str());
+        throw SZ_MD5_Exception("Create digest cache \"" + path + "\" failed: " + strerror(err));
+    }
+#else
+    (void)path;
+    (void)capacity;
+#endif
+}
+
+void SZ_MD5Cache::unmap()
+{
+#if !defined SZ_TARGET_PLATFORM_WINDOWS
+    if (nullptr != map_)
+    {
+        munmap(map_, mapSize_);
+    }
+#endif
+    map_ = nullptr;
+    mapSize_ = 0;
+    header_ = nullptr;
+    entries_ = nullptr;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "SZMD5.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief md5file的持久化摘要缓存
+ *        以(设备号, inode, 大小, 修改时间ns)为键, 命中时只需一次stat, 不读取文件内容
+ *        索引为mmap映射的定长开放寻址表, 多进程可同时使用同一索引文件:
+ *        读取不加文件锁(进程内以互斥锁保护映射), 每个条目以序号校验读到的是完整写入; 写入以旁路锁文件串行
+ *        写入中途退出的进程留下的条目查找时跳过, 之后的写入经过该条目时将其作废, 重建时丢弃
+ *        表满75%时重建为两倍大小的新文件并原子替换, 其他进程发现旧文件失效后重新映射
+ *        修改时间距当前不足1秒的文件不写入缓存, 避免同一时间粒度内的再次修改被漏判
+ */
+class SZ_MD5Cache : public SZ_Uncopy
+{
+public:
+    /**
+     * @brief
+     *
+     * @param indexFile 索引文件路径, 不存在时创建
+     * @param capacity 新建索引的初始条目数
+     */
+    explicit SZ_MD5Cache(const std::string &indexFile, size_t capacity = 4096);
+
+    ~SZ_MD5Cache();
+
+    /**
+     * @brief 32位十六进制数, 命中缓存时不读取文件
+     *
+     * @param fileName
+     * @return std::string
+     */
+    std::string md5file(const std::string &fileName);
+
+    /**
+     * @brief 只查询缓存, 不计算
+     *
+     * @param fileName
+     * @param md5 命中时输出32位十六进制数
+     * @return bool
+     */
+    bool lookup(const std::string &fileName, std::string &md5);
+
+    /**
+     * @brief 已缓存的条目数
+     *
+     * @return size_t
+     */
+    size_t size();
+
+    /**
+     * @brief 清空缓存
+     */
+    void clear();
+
+    /**
+     * @brief 命中次数
+     *
+     * @return uint64_t
+     */
+    uint64_t hits() const;
+
+    /**
+     * @brief 未命中次数
+     *
+     * @return uint64_t
+     */
+    uint64_t misses() const;
+
+protected:
+    struct Key
+    {
+        uint64_t dev;
+        uint64_t ino;
+        uint64_t size;
+        int64_t mtimeNs;
+    };
+
+    /**
+     * @brief 取文件的缓存键
+     *
+     * @param fileName
+     * @param key
+     * @return bool 文件不存在或不是普通文件时返回false
+     */
+    static bool statKey(const std::string &fileName, Key &key);
+
+    /**
+     * @brief 查找条目, 需持有mapMtx_
+     *
+     * @param key
+     * @param digest
+     * @return bool
+     */
+    bool find(const Key &key, unsigned char digest[16]);
+
+    /**
+     * @brief 写入条目, 需持有mapMtx_
+     *
+     * @param key
+     * @param digest
+     */
+    void insert(const Key &key, const unsigned char digest[16]);
+
+    /**
+     * @brief 作废写入中途退出的进程留下的条目, 需持有写锁
+     *
+     * @param slot
+     */
+    void repair(uint64_t slot);
+
+    /**
+     * @brief 映射索引文件, 不存在或已失效时重新创建
+     *
+     * @param create 不存在时是否创建
+     */
+    void remap(bool create);
+
+    /**
+     * @brief 重建为两倍容量, 需持有写锁
+     */
+    void grow();
+
+    /**
+     * @brief 创建空索引文件
+     *
+     * @param path
+     * @param capacity
+     */
+    static void createIndex(const std::string &path, uint64_t capacity);
+
+    /**
+     * @brief 解除当前映射
+     */
+    void unmap();
+
+private:
+    struct Header;
+    struct Entry;
+
+    std::string indexFile_;
+    size_t capacity_;
+    int lockFd_;
+    bool writable_;
+
+    std::mutex mapMtx_;
+    char *map_;
+    size_t mapSize_;
+    Header *header_;
+    Entry *entries_;
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+};
@@ -0,0 +1,392 @@
+#include "SZMD5Multi.h"
+
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SZ_MD5_MULTI_X86 1
+#include <immintrin.h>
+#endif
+
+// 通道状态与消息字按 [字][通道] 排列, 按最大通道数分配
+static const size_t MAX_LANES = 16;
+
+typedef void (*CompressFunc)(uint32_t state[4][MAX_LANES], const uint32_t words[16][MAX_LANES]);
+
+// 64轮运算, 由各引擎定义 SZ_V_* 向量操作后展开
+#define SZ_MD5_STEP(f, a, b, c, d, k, s, t)                                           \
+    a = SZ_V_ADD(a, SZ_V_ADD(f(b, c, d), SZ_V_ADD(SZ_V_LOAD(words[k]), SZ_V_SET(t)))); \
+    a = SZ_V_ADD(SZ_V_ROL(a, s), b);
+
+#define SZ_MD5_F(x, y, z) SZ_V_XOR(z, SZ_V_AND(x, SZ_V_XOR(y, z)))
+#define SZ_MD5_G(x, y, z) SZ_V_XOR(y, SZ_V_AND(z, SZ_V_XOR(x, y)))
+#define SZ_MD5_H(x, y, z) SZ_V_XOR(SZ_V_XOR(x, y), z)
+#define SZ_MD5_I(x, y, z) SZ_V_XOR(y, SZ_V_OR(x, SZ_V_NOT(z)))
+
+#define SZ_MD5_ROUNDS                                                \
+    SZ_MD5_STEP(SZ_MD5_F, A, B, C, D, 0, 7, 0xD76AA478)              \
+    SZ_MD5_STEP(SZ_MD5_F, D, A, B, C, 1, 12, 0xE8C7B756)             \
+    SZ_MD5_STEP(SZ_MD5_F, C, D, A, B, 2, 17, 0x242070DB)             \
+    SZ_MD5_STEP(SZ_MD5_F, B, C, D, A, 3, 22, 0xC1BDCEEE)             \
+    SZ_MD5_STEP(SZ_MD5_F, A, B, C, D, 4, 7, 0xF57C0FAF)              \
+    SZ_MD5_STEP(SZ_MD5_F, D, A, B, C, 5, 12, 0x4787C62A)             \
+    SZ_MD5_STEP(SZ_MD5_F, C, D, A, B, 6, 17, 0xA8304613)             \
+    SZ_MD5_STEP(SZ_MD5_F, B, C, D, A, 7, 22, 0xFD469501)             \
+    SZ_MD5_STEP(SZ_MD5_F, A, B, C, D, 8, 7, 0x698098D8)              \
+    SZ_MD5_STEP(SZ_MD5_F, D, A, B, C, 9, 12, 0x8B44F7AF)             \
+    SZ_MD5_STEP(SZ_MD5_F, C, D, A, B, 10, 17, 0xFFFF5BB1)            \
+    SZ_MD5_STEP(SZ_MD5_F, B, C, D, A, 11, 22, 0x895CD7BE)            \
+    SZ_MD5_STEP(SZ_MD5_F, A, B, C, D, 12, 7, 0x6B901122)             \
+    SZ_MD5_STEP(SZ_MD5_F, D, A, B, C, 13, 12, 0xFD987193)            \
+    SZ_MD5_STEP(SZ_MD5_F, C, D, A, B, 14, 17, 0xA679438E)            \
+    SZ_MD5_STEP(SZ_MD5_F, B, C, D, A, 15, 22, 0x49B40821)            \
+    SZ_MD5_STEP(SZ_MD5_G, A, B, C, D, 1, 5, 0xF61E2562)              \
+    SZ_MD5_STEP(SZ_MD5_G, D, A, B, C, 6, 9, 0xC040B340)              \
+    SZ_MD5_STEP(SZ_MD5_G, C, D, A, B, 11, 14, 0x265E5A51)            \
+    SZ_MD5_STEP(SZ_MD5_G, B, C, D, A, 0, 20, 0xE9B6C7AA)             \
+    SZ_MD5_STEP(SZ_MD5_G, A, B, C, D, 5, 5, 0xD62F105D)              \
+    SZ_MD5_STEP(SZ_MD5_G, D, A, B, C, 10, 9, 0x02441453)             \
+    SZ_MD5_STEP(SZ_MD5_G, C, D, A, B, 15, 14, 0xD8A1E681)            \
+    SZ_MD5_STEP(SZ_MD5_G, B, C, D, A, 4, 20, 0xE7D3FBC8)             \
+    SZ_MD5_STEP(SZ_MD5_G, A, B, C, D, 9, 5, 0x21E1CDE6)              \
+    SZ_MD5_STEP(SZ_MD5_G, D, A, B, C, 14, 9, 0xC33707D6)             \
+    SZ_MD5_STEP(SZ_MD5_G, C, D, A, B, 3, 14, 0xF4D50D87)             \
+    SZ_MD5_STEP(SZ_MD5_G, B, C, D, A, 8, 20, 0x455A14ED)             \
+    SZ_MD5_STEP(SZ_MD5_G, A, B, C, D, 13, 5, 0xA9E3E905)             \
+    SZ_MD5_STEP(SZ_MD5_G, D, A, B, C, 2, 9, 0xFCEFA3F8)              \
+    SZ_MD5_STEP(SZ_MD5_G, C, D, A, B, 7, 14, 0x676F02D9)             \
+    SZ_MD5_STEP(SZ_MD5_G, B, C, D, A, 12, 20, 0x8D2A4C8A)            \
+    SZ_MD5_STEP(SZ_MD5_H, A, B, C, D, 5, 4, 0xFFFA3942)              \
+    SZ_MD5_STEP(SZ_MD5_H, D, A, B, C, 8, 11, 0x8771F681)             \
+    SZ_MD5_STEP(SZ_MD5_H, C, D, A, B, 11, 16, 0x6D9D6122)            \
+    SZ_MD5_STEP(SZ_MD5_H, B, C, D, A, 14, 23, 0xFDE5380C)            \
+    SZ_MD5_STEP(SZ_MD5_H, A, B, C, D, 1, 4, 0xA4BEEA44)              \
+    SZ_MD5_STEP(SZ_MD5_H, D, A, B, C, 4, 11, 0x4BDECFA9)             \
+    SZ_MD5_STEP(SZ_MD5_H, C, D, A, B, 7, 16, 0xF6BB4B60)             \
+    SZ_MD5_STEP(SZ_MD5_H, B, C, D, A, 10, 23, 0xBEBFBC70)            \
+    SZ_MD5_STEP(SZ_MD5_H, A, B, C, D, 13, 4, 0x289B7EC6)             \
+    SZ_MD5_STEP(SZ_MD5_H, D, A, B, C, 0, 11, 0xEAA127FA)             \
+    SZ_MD5_STEP(SZ_MD5_H, C, D, A, B, 3, 16, 0xD4EF3085)             \
+    SZ_MD5_STEP(SZ_MD5_H, B, C, D, A, 6, 23, 0x04881D05)             \
+    SZ_MD5_STEP(SZ_MD5_H, A, B, C, D, 9, 4, 0xD9D4D039)              \
+    SZ_MD5_STEP(SZ_MD5_H, D, A, B, C, 12, 11, 0xE6DB99E5)            \
+    SZ_MD5_STEP(SZ_MD5_H, C, D, A, B, 15, 16, 0x1FA27CF8)            \
+    SZ_MD5_STEP(SZ_MD5_H, B, C, D, A, 2, 23, 0xC4AC5665)             \
+    SZ_MD5_STEP(SZ_MD5_I, A, B, C, D, 0, 6, 0xF4292244)              \
+    SZ_MD5_STEP(SZ_MD5_I, D, A, B, C, 7, 10, 0x432AFF97)             \
+    SZ_MD5_STEP(SZ_MD5_I, C, D, A, B, 14, 15, 0xAB9423A7)            \
+    SZ_MD5_STEP(SZ_MD5_I, B, C, D, A, 5, 21, 0xFC93A039)             \
+    SZ_MD5_STEP(SZ_MD5_I, A, B, C, D, 12, 6, 0x655B59C3)             \
+    SZ_MD5_STEP(SZ_MD5_I, D, A, B, C, 3, 10, 0x8F0CCC92)             \
+    SZ_MD5_STEP(SZ_MD5_I, C, D, A, B, 10, 15, 0xFFEFF47D)            \
+    SZ_MD5_STEP(SZ_MD5_I, B, C, D, A, 1, 21, 0x85845DD1)             \
+    SZ_MD5_STEP(SZ_MD5_I, A, B, C, D, 8, 6, 0x6FA87E4F)              \
+    SZ_MD5_STEP(SZ_MD5_I, D, A, B, C, 15, 10, 0xFE2CE6E0)            \
+    SZ_MD5_STEP(SZ_MD5_I, C, D, A, B, 6, 15, 0xA3014314)             \
+    SZ_MD5_STEP(SZ_MD5_I, B, C, D, A, 13, 21, 0x4E0811A1)            \
+    SZ_MD5_STEP(SZ_MD5_I, A, B, C, D, 4, 6, 0xF7537E82)              \
+    SZ_MD5_STEP(SZ_MD5_I, D, A, B, C, 11, 10, 0xBD3AF235)            \
+    SZ_MD5_STEP(SZ_MD5_I, C, D, A, B, 2, 15, 0x2AD7D2BB)             \
+    SZ_MD5_STEP(SZ_MD5_I, B, C, D, A, 9, 21, 0xEB86D391)
+
+#if defined SZ_MD5_MULTI_X86
+
+__attribute__((target("avx2"))) static void compressAVX2(uint32_t state[4][MAX_LANES], const uint32_t words[16][MAX_LANES])
+{
+#define SZ_V_LOAD(p) _mm256_load_si256((const __m256i *)(p))
+#define SZ_V_SET(t) _mm256_set1_epi32((int)(t))
+#define SZ_V_ADD(x, y) _mm256_add_epi32(x, y)
+#define SZ_V_AND(x, y) _mm256_and_si256(x, y)
+#define SZ_V_OR(x, y) _mm256_or_si256(x, y)
+#define SZ_V_XOR(x, y) _mm256_xor_si256(x, y)
+#define SZ_V_NOT(x) _mm256_xor_si256(x, _mm256_set1_epi32(-1))
+#define SZ_V_ROL(x, n) _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+
+    __m256i A = SZ_V_LOAD(state[0]);
+    __m256i B = SZ_V_LOAD(state[1]);
+    __m256i C = SZ_V_LOAD(state[2]);
+    __m256i D = SZ_V_LOAD(state[3]);
+    __m256i AA = A, BB = B, CC = C, DD = D;
+
+    SZ_MD5_ROUNDS
+
+    _mm256_store_si256((__m256i *)state[0], SZ_V_ADD(A, AA));
+    _mm256_store_si256((__m256i *)state[1], SZ_V_ADD(B, BB));
+    _mm256_store_si256((__m256i *)state[2], SZ_V_ADD(C, CC));
+    _mm256_store_si256((__m256i *)state[3], SZ_V_ADD(D, DD));
+
+#undef SZ_V_LOAD
+#undef SZ_V_SET
+#undef SZ_V_ADD
+#undef SZ_V_AND
+#undef SZ_V_OR
+#undef SZ_V_XOR
+#undef SZ_V_NOT
+#undef SZ_V_ROL
+}
+
+// GCC 12的avx512头文件在-Wall下会误报未初始化
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+__attribute__((target("avx512f"))) static void compressAVX512(uint32_t state[4][MAX_LANES], const uint32_t words[16][MAX_LANES])
+{
+#define SZ_V_LOAD(p) _mm512_load_si512((const void *)(p))
+#define SZ_V_SET(t) _mm512_set1_epi32((int)(t))
+#define SZ_V_ADD(x, y) _mm512_add_epi32(x, y)
+#define SZ_V_AND(x, y) _mm512_and_si512(x, y)
+#define SZ_V_OR(x, y) _mm512_or_si512(x, y)
+#define SZ_V_XOR(x, y) _mm512_xor_si512(x, y)
+#define SZ_V_NOT(x) _mm512_xor_si512(x, _mm512_set1_epi32(-1))
+#define SZ_V_ROL(x, n) _mm512_rol_epi32(x, n)
+
+    __m512i A = SZ_V_LOAD(state[0]);
+    __m512i B = SZ_V_LOAD(state[1]);
+    __m512i C = SZ_V_LOAD(state[2]);
+    __m512i D = SZ_V_LOAD(state[3]);
+    __m512i AA = A, BB = B, CC = C, DD = D;
+
+    SZ_MD5_ROUNDS
+
+    _mm512_store_si512((void *)state[0], SZ_V_ADD(A, AA));
+    _mm512_store_si512((void *)state[1], SZ_V_ADD(B, BB));
+    _mm512_store_si512((void *)state[2], SZ_V_ADD(C, CC));
+    _mm512_store_si512((void *)state[3], SZ_V_ADD(D, DD));
+
+#undef SZ_V_LOAD
+#undef SZ_V_SET
+#undef SZ_V_ADD
+#undef SZ_V_AND
+#undef SZ_V_OR
+#undef SZ_V_XOR
+#undef SZ_V_NOT
+#undef SZ_V_ROL
+}
+
+#pragma GCC diagnostic pop
+
+#endif // SZ_MD5_MULTI_X86
+
+/**
+ * @brief 单个通道上正在计算的消息
+ */
+struct SZ_MD5Lane
+{
+    bool busy;
+    size_t index;               // 消息序号
+    const unsigned char *data;  // 剩余的完整块
+    size_t blocks;              // 剩余完整块数
+    unsigned char tail[128];    // 末尾不足一块的数据与填充
+    size_t tailBlocks;
+    size_t tailPos;
+
+    void assign(size_t i, const char *buffer, size_t length)
+    {
+        busy = true;
+        index = i;
+        data = reinterpret_cast<const unsigned char *>(buffer);
+        blocks = length / 64;
+        tailPos = 0;
+
+        size_t rest = length % 64;
+        tailBlocks = rest < 56 ? 1 : 2;
+        memset(tail, 0, sizeof(tail));
+        if (rest > 0)
+        {
+            memcpy(tail, data + blocks * 64, rest);
+        }
+        tail[rest] = 0x80;
+
+        uint64_t bits = static_cast<uint64_t>(length) << 3;
+        unsigned char *p = tail + tailBlocks * 64 - 8;
+        for (int i = 0; i < 8; ++i)
+        {
+            p[i] = static_cast<unsigned char>(bits >> (8 * i));
+        }
+    }
+
+    const unsigned char *block() const
+    {
+        return blocks > 0 ? data : tail + tailPos * 64;
+    }
+
+    // 前进一块, 消息结束时返回true
+    bool advance()
+    {
+        if (blocks > 0)
+        {
+            data += 64;
+            --blocks;
+            return false;
+        }
+        return ++tailPos == tailBlocks;
+    }
+};
+
+static void resetLane(uint32_t state[4][MAX_LANES], size_t lane)
+{
+    state[0][lane] = 0x67452301;
+    state[1][lane] = 0xefcdab89;
+    state[2][lane] = 0x98badcfe;
+    state[3][lane] = 0x10325476;
+}
+
+static void hashLanes(size_t lanes, CompressFunc compress, const char *const *buffers, const size_t *lengths, size_t count, SZ_MD5Multi::Digest *digests)
+{
+    alignas(64) uint32_t state[4][MAX_LANES];
+    alignas(64) uint32_t words[16][MAX_LANES];
+    static const unsigned char idle[64] = {0};
+
+    SZ_MD5Lane lane[MAX_LANES];
+    size_t next = 0;
+    size_t busy = 0;
+    for (size_t i = 0; i < lanes; ++i)
+    {
+        resetLane(state, i);
+        lane[i].busy = false;
+        if (next < count)
+        {
+            lane[i].assign(next, buffers[next], lengths[next]);
+            ++next;
+            ++busy;
+        }
+    }
+
+    while (busy > 0)
+    {
+        // 转置: 每条消息当前块的第k个字放到words[k][通道]
+        for (size_t i = 0; i < lanes; ++i)
+        {
+            const unsigned char *block = lane[i].busy ? lane[i].block() : idle;
+            for (size_t k = 0; k < 16; ++k)
+            {
+                const unsigned char *p = block + k * 4;
+                words[k][i] = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                              (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+            }
+        }
+
+        compress(state, words);
+
+        for (size_t i = 0; i < lanes; ++i)
+        {
+            if (!lane[i].busy || !lane[i].advance())
+            {
+                continue;
+            }
+
+            unsigned char *out = digests[lane[i].index].bytes.data();
+            for (size_t j = 0; j < 4; ++j)
+            {
+                out[j * 4] = static_cast<unsigned char>(state[j][i]);
+                out[j * 4 + 1] = static_cast<unsigned char>(state[j][i] >> 8);
+                out[j * 4 + 2] = static_cast<unsigned char>(state[j][i] >> 16);
+                out[j * 4 + 3] = static_cast<unsigned char>(state[j][i] >> 24);
+            }
+
+            resetLane(state, i);
+            if (next < count)
+            {
+                lane[i].assign(next, buffers[next], lengths[next]);
+                ++next;
+            }
+            else
+            {
+                lane[i].busy = false;
+                --busy;
+            }
+        }
+    }
+}
+
+static std::atomic<int> &currentEngine()
+{
+    static std::atomic<int> eng(SZ_MD5Multi::detect());
+    return eng;
+}
+
+SZ_MD5Multi::Engine SZ_MD5Multi::detect()
+{
+#if defined SZ_MD5_MULTI_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return ENGINE_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return ENGINE_AVX2;
+    }
+#endif
+    return ENGINE_SCALAR;
+}
+
+SZ_MD5Multi::Engine SZ_MD5Multi::engine()
+{
+    return static_cast<Engine>(currentEngine().load(std::memory_order_relaxed));
+}
+
+SZ_MD5Multi::Engine SZ_MD5Multi::setEngine(Engine eng)
+{
+    Engine best = detect();
+    if (eng > best)
+    {
+        eng = best;
+    }
+    currentEngine().store(eng);
+
+    return eng;
+}
+
+void SZ_MD5Multi::md5bin(const char *const *buffers, const size_t *lengths, size_t count, Digest *digests)
+{
+    switch (engine())
+    {
+#if defined SZ_MD5_MULTI_X86
+    case ENGINE_AVX512:
+        hashLanes(16, compressAVX512, buffers, lengths, count, digests);
+        return;
+    case ENGINE_AVX2:
+        hashLanes(8, compressAVX2, buffers, lengths, count, digests);
+        return;
+#endif
+    default:
+        break;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        SZ_MD5Hasher hasher;
+        hasher.update(buffers[i], lengths[i]);
+        hasher.finalize(digests[i].bytes.data());
+    }
+}
+
+std::vector<SZ_MD5Multi::Digest> SZ_MD5Multi::md5bin(const std::vector<std::string> &buffers)
+{
+    std::vector<const char *> vBuffers;
+    std::vector<size_t> vLengths;
+    vBuffers.reserve(buffers.size());
+    vLengths.reserve(buffers.size());
+    for (auto &buffer : buffers)
+    {
+        vBuffers.push_back(buffer.data());
+        vLengths.push_back(buffer.size());
+    }
+
+    std::vector<Digest> vDigests(buffers.size());
+    md5bin(vBuffers.data(), vLengths.data(), buffers.size(), vDigests.data());
+
+    return vDigests;
+}
+
+std::vector<std::string> SZ_MD5Multi::md5str(const std::vector<std::string> &buffers)
+{
+    std::vector<std::string> vResult;
+    vResult.reserve(buffers.size());
+    for (auto &digest : md5bin(buffers))
+    {
+        vResult.push_back(digest.str());
+    }
+
+    return vResult;
+}
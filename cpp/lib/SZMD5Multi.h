@@ -0,0 +1,73 @@
+#pragma once
+
+#include "SZMD5.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief 多路并行MD5, 每个SIMD通道计算一条独立消息
+ *        运行期按CPUID选择AVX-512(16路)、AVX2(8路)或逐条计算
+ *        适合大量短消息的批量计算, 单条长消息请使用SZ_MD5
+ */
+class SZ_MD5Multi
+{
+public:
+    enum Engine
+    {
+        ENGINE_SCALAR = 0,
+        ENGINE_AVX2 = 8,
+        ENGINE_AVX512 = 16,
+    };
+
+    typedef SZ_MD5Digest Digest;
+
+public:
+    /**
+     * @brief 当前使用的引擎
+     *
+     * @return Engine
+     */
+    static Engine engine();
+
+    /**
+     * @brief 指定引擎, CPU不支持时退回可用的最高级引擎
+     *
+     * @param eng
+     * @return Engine 实际使用的引擎
+     */
+    static Engine setEngine(Engine eng);
+
+    /**
+     * @brief CPU支持的最高级引擎
+     *
+     * @return Engine
+     */
+    static Engine detect();
+
+    /**
+     * @brief 批量计算16位二进制摘要
+     *
+     * @param buffers
+     * @param lengths
+     * @param count
+     * @param digests 输出, 至少count个
+     */
+    static void md5bin(const char *const *buffers, const size_t *lengths, size_t count, Digest *digests);
+
+    /**
+     * @brief 批量计算16位二进制摘要
+     *
+     * @param buffers
+     * @return std::vector<Digest>
+     */
+    static std::vector<Digest> md5bin(const std::vector<std::string> &buffers);
+
+    /**
+     * @brief 批量计算32位十六进制摘要
+     *
+     * @param buffers
+     * @return std::vector<std::string>
+     */
+    static std::vector<std::string> md5str(const std::vector<std::string> &buffers);
+};
@@ -0,0 +1,630 @@
+#include "SZMD5Pipeline.h"
+
+#include <deque>
+#include <map>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined SZ_TARGET_PLATFORM_LINUX && defined __has_include
+#if __has_include(<linux/io_uring.h>)
+#define SZ_MD5_PIPELINE_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+struct SZ_MD5Pipeline::FileState
+{
+    std::string path;
+    int fd;              // 仅读线程打开与关闭
+    uint64_t size;
+    uint64_t readOffset; // 下一个待提交读请求的偏移, 仅读线程访问
+    bool reading;        // 是否还在读线程的轮转队列中, 仅读线程访问
+    uint64_t hashOffset; // 下一个待计算数据块的偏移
+    size_t outstanding;  // 在途读请求数
+    bool hashing;        // 是否已有计算任务
+    bool failed;
+    std::string error;
+    std::map<uint64_t, Chunk *> ready; // 已读完待计算的数据块
+    SZ_MD5Hasher hasher;
+    std::atomic_bool done;
+    std::mutex mtx;
+
+    FileState() : fd(-1), size(0), readOffset(0), reading(false), hashOffset(0), outstanding(0), hashing(false), failed(false), done(false) {}
+};
+
+struct SZ_MD5Pipeline::Chunk
+{
+    std::shared_ptr<FileState> file;
+    char *buffer;
+    uint64_t offset;
+    size_t length;
+};
+
+#if defined SZ_MD5_PIPELINE_URING
+
+/**
+ * @brief 直接基于系统调用的最小io_uring封装, 只使用IORING_OP_READ
+ */
+struct SZ_MD5Pipeline::Ring
+{
+    int fd;
+    unsigned entries;
+    unsigned toSubmit;
+
+    void *sqPtr;
+    size_t sqSize;
+    void *cqPtr;
+    size_t cqSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+
+    Ring() : fd(-1), entries(0), toSubmit(0), sqPtr(MAP_FAILED), sqSize(0), cqPtr(MAP_FAILED), cqSize(0),
+             sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)), sqesSize(0) {}
+
+    ~Ring()
+    {
+        if (sqes != MAP_FAILED)
+        {
+            munmap(sqes, sqesSize);
+        }
+        if (cqPtr != MAP_FAILED && cqPtr != sqPtr)
+        {
+            munmap(cqPtr, cqSize);
+        }
+        if (sqPtr != MAP_FAILED)
+        {
+            munmap(sqPtr, sqSize);
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    bool init(unsigned depth)
+    {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+        if (fd < 0)
+        {
+            return false;
+        }
+        entries = params.sq_entries;
+
+        sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+        {
+            sqSize = cqSize = std::max(sqSize, cqSize);
+        }
+
+        sqPtr = mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqPtr == MAP_FAILED)
+        {
+            return false;
+        }
+        cqPtr = single ? sqPtr : mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqPtr == MAP_FAILED)
+        {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqes = static_cast<struct io_uring_sqe *>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        char *sq = static_cast<char *>(sqPtr);
+        char *cq = static_cast<char *>(cqPtr);
+        sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        return probeRead();
+    }
+
+    /**
+     * @brief IORING_OP_READ从5.6开始才有, 更早的内核能建立io_uring但每个读请求都以-EINVAL完成
+     *        IORING_REGISTER_PROBE与之同版本加入, 探测失败也视为不支持
+     */
+    bool probeRead()
+    {
+        const unsigned ops = 256;
+        std::vector<char> buf(sizeof(struct io_uring_probe) + ops * sizeof(struct io_uring_probe_op), 0);
+        struct io_uring_probe *probe = reinterpret_cast<struct io_uring_probe *>(buf.data());
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, ops) < 0)
+        {
+            return false;
+        }
+
+        return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    void read(int file, void *buffer, unsigned length, uint64_t offset, void *user)
+    {
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+
+        struct io_uring_sqe *sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = file;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->len = length;
+        sqe->off = offset;
+        sqe->user_data = reinterpret_cast<uint64_t>(user);
+
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++toSubmit;
+    }
+
+    /**
+     * @brief 提交并等待至少一个完成事件
+     */
+    void submitAndWait()
+    {
+        while (true)
+        {
+            long ret = syscall(__NR_io_uring_enter, fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret >= 0)
+            {
+                toSubmit -= static_cast<unsigned>(ret) < toSubmit ? static_cast<unsigned>(ret) : toSubmit;
+                if (toSubmit == 0)
+                {
+                    return;
+                }
+            }
+            else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                throw SZ_MD5_Exception(std::string("io_uring_enter failed: ") + strerror(errno));
+            }
+        }
+    }
+
+    template <typename Func>
+    size_t reap(Func &&func)
+    {
+        size_t n = 0;
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            struct io_uring_cqe *cqe = &cqes[head & *cqMask];
+            func(reinterpret_cast<void *>(cqe->user_data), static_cast<long>(cqe->res));
+            ++head;
+            ++n;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+        return n;
+    }
+};
+
+#else
+
+struct SZ_MD5Pipeline::Ring
+{
+};
+
+#endif // SZ_MD5_PIPELINE_URING
+
+SZ_MD5Pipeline::SZ_MD5Pipeline(size_t threads, size_t depth, size_t buffers, size_t bufferSize, size_t openFiles)
+    : depth_(depth > 0 ? depth : 1), bufferSize_(bufferSize > 0 ? bufferSize : 512 * 1024), openFiles_(openFiles > 0 ? openFiles : 1),
+      freeBuffers_(std::max(buffers, depth_)), remaining_(0)
+{
+#if defined SZ_MD5_PIPELINE_URING
+    ring_.reset(new Ring());
+    if (!ring_->init(static_cast<unsigned>(depth_)))
+    {
+        ring_.reset();
+    }
+    else
+    {
+        depth_ = std::min<size_t>(depth_, ring_->entries);
+    }
+#endif
+
+    size_t count = std::max(buffers, depth_);
+    for (size_t i = 0; i < count; ++i)
+    {
+        char *buffer = nullptr;
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+        buffer = static_cast<char *>(malloc(bufferSize_));
+#else
+        void *p = nullptr;
+        if (posix_memalign(&p, 4096, bufferSize_) == 0)
+        {
+            buffer = static_cast<char *>(p);
+        }
+#endif
+        if (nullptr == buffer)
+        {
+            for (auto allocated : vBuffers_)
+            {
+                free(allocated);
+            }
+            throw SZ_MD5_Exception("Alloc pipeline buffer failed");
+        }
+        vBuffers_.push_back(buffer);
+        freeBuffers_.push(buffer);
+    }
+
+    pool_.start(threads);
+}
+
+SZ_MD5Pipeline::~SZ_MD5Pipeline()
+{
+    pool_.stop();
+    for (auto buffer : vBuffers_)
+    {
+        free(buffer);
+    }
+}
+
+bool SZ_MD5Pipeline::isAsync() const
+{
+    return ring_ != nullptr;
+}
+
+void SZ_MD5Pipeline::hashFiles(const std::vector<std::string> &paths, const Callback &callback)
+{
+    std::lock_guard<std::mutex> runLocker(runMtx_);
+    if (paths.empty())
+    {
+        return;
+    }
+
+    callback_ = callback;
+    remaining_.store(paths.size());
+
+    readLoop(paths);
+
+    std::unique_lock<std::mutex> locker(doneMtx_);
+    doneCond_.wait(locker, [this]()
+                   { return remaining_.load() == 0; });
+    callback_ = nullptr;
+}
+
+void SZ_MD5Pipeline::readLoop(const std::vector<std::string> &paths)
+{
+    size_t next = 0;
+    size_t inflight = 0;
+    char *held = nullptr;
+    std::deque<std::shared_ptr<FileState>> active;
+
+    while (true)
+    {
+        // 打开新文件直到读取中的文件数达到上限
+        while (next < paths.size() && active.size() < openFiles_)
+        {
+            std::shared_ptr<FileState> file = std::make_shared<FileState>();
+            file->path = paths[next++];
+
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+            file->fd = ::open(file->path.c_str(), O_RDONLY | O_BINARY);
+#else
+            file->fd = ::open(file->path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+            if (file->fd < 0)
+            {
+                finish(file, "Can not open file \"" + file->path + "\": " + strerror(errno));
+                continue;
+            }
+
+            struct stat st;
+            if (fstat(file->fd, &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                closeFile(file);
+                finish(file, "Not a regular file \"" + file->path + "\"");
+                continue;
+            }
+
+            file->size = static_cast<uint64_t>(st.st_size);
+            if (file->size == 0)
+            {
+                closeFile(file);
+                finish(file, "");
+                continue;
+            }
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+            posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+            file->reading = true;
+            active.push_back(file);
+        }
+
+        // 轮流为各文件提交下一块的读请求
+        while (!active.empty() && inflight < depth_)
+        {
+            char *buffer = held;
+            held = nullptr;
+            if (nullptr == buffer && !freeBuffers_.pop(buffer, 0))
+            {
+                break;
+            }
+
+            std::shared_ptr<FileState> file = active.front();
+            active.pop_front();
+
+            // 已失败的文件不再提交读请求, 没有在途请求时即可关闭
+            bool failed;
+            size_t outstanding;
+            {
+                std::lock_guard<std::mutex> locker(file->mtx);
+                failed = file->failed;
+                if (!failed)
+                {
+                    ++file->outstanding;
+                }
+                outstanding = file->outstanding;
+            }
+            if (failed)
+            {
+                file->reading = false;
+                if (0 == outstanding)
+                {
+                    closeFile(file);
+                }
+                held = buffer;
+                continue;
+            }
+
+            Chunk *chunk = new Chunk();
+            chunk->file = file;
+            chunk->buffer = buffer;
+            chunk->offset = file->readOffset;
+            chunk->length = static_cast<size_t>(std::min<uint64_t>(bufferSize_, file->size - file->readOffset));
+            file->readOffset += chunk->length;
+
+            if (file->readOffset < file->size)
+            {
+                active.push_back(file);
+            }
+            else
+            {
+                file->reading = false;
+            }
+
+#if defined SZ_MD5_PIPELINE_URING
+            if (ring_)
+            {
+                ring_->read(file->fd, chunk->buffer, static_cast<unsigned>(chunk->length), chunk->offset, chunk);
+                ++inflight;
+                continue;
+            }
+#endif
+
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+            long result = -1;
+            if (_lseeki64(file->fd, chunk->offset, SEEK_SET) >= 0)
+            {
+                result = ::read(file->fd, chunk->buffer, static_cast<unsigned>(chunk->length));
+            }
+#else
+            ssize_t result;
+            do
+            {
+                result = ::pread(file->fd, chunk->buffer, chunk->length, static_cast<off_t>(chunk->offset));
+            } while (result < 0 && errno == EINTR);
+#endif
+            onRead(chunk, result < 0 ? -errno : static_cast<long>(result));
+        }
+
+#if defined SZ_MD5_PIPELINE_URING
+        if (inflight > 0)
+        {
+            ring_->submitAndWait();
+            inflight -= ring_->reap([this](void *user, long result)
+                                    { onRead(static_cast<Chunk *>(user), result); });
+            continue;
+        }
+#endif
+
+        if (active.empty() && next >= paths.size())
+        {
+            break;
+        }
+
+        if (!active.empty() && nullptr == held)
+        {
+            // 缓冲全部在计算中, 等待归还
+            freeBuffers_.pop(held, -1);
+        }
+    }
+
+    if (nullptr != held)
+    {
+        release(held);
+    }
+}
+
+void SZ_MD5Pipeline::onRead(Chunk *chunk, long result)
+{
+    std::shared_ptr<FileState> file = chunk->file;
+
+    bool schedule = false;
+    bool drop = false;
+    bool report = false;
+    bool idle = false;
+    {
+        std::lock_guard<std::mutex> locker(file->mtx);
+        --file->outstanding;
+        idle = !file->reading && file->outstanding == 0;
+
+        if (!file->failed && (result < 0 || static_cast<size_t>(result) != chunk->length))
+        {
+            file->failed = true;
+            file->error = "Read file \"" + file->path + "\" failed: " + (result < 0 ? strerror(static_cast<int>(-result)) : "short read");
+        }
+
+        if (file->failed)
+        {
+            // 失败文件的数据块直接丢弃, 由最后一个在途请求或计算任务报告
+            drop = true;
+            report = file->outstanding == 0 && !file->hashing;
+        }
+        else
+        {
+            file->ready[chunk->offset] = chunk;
+            if (!file->hashing && file->ready.begin()->first == file->hashOffset)
+            {
+                file->hashing = true;
+                schedule = true;
+            }
+        }
+    }
+
+    // onRead只在读线程调用, 最后一个读请求完成且不会再提交时关闭
+    if (idle)
+    {
+        closeFile(file);
+    }
+
+    if (drop)
+    {
+        release(chunk->buffer);
+        delete chunk;
+        if (report)
+        {
+            finish(file, file->error);
+        }
+        return;
+    }
+
+    if (schedule)
+    {
+        pool_.insert([this, file]()
+                     { drain(file); });
+    }
+}
+
+void SZ_MD5Pipeline::drain(std::shared_ptr<FileState> file)
+{
+    size_t hashed = 0;
+    while (true)
+    {
+        Chunk *chunk = nullptr;
+        bool report = false;
+        std::vector<Chunk *> vDropped;
+        {
+            std::lock_guard<std::mutex> locker(file->mtx);
+            file->hashOffset += hashed;
+            hashed = 0;
+
+            if (file->failed)
+            {
+                for (auto &item : file->ready)
+                {
+                    vDropped.push_back(item.second);
+                }
+                file->ready.clear();
+                file->hashing = false;
+                report = file->outstanding == 0;
+            }
+            else if (file->hashOffset == file->size)
+            {
+                file->hashing = false;
+                report = true;
+            }
+            else
+            {
+                auto it = file->ready.find(file->hashOffset);
+                if (it == file->ready.end())
+                {
+                    file->hashing = false;
+                    return;
+                }
+                chunk = it->second;
+                file->ready.erase(it);
+            }
+        }
+
+        if (nullptr == chunk)
+        {
+            for (auto dropped : vDropped)
+            {
+                release(dropped->buffer);
+                delete dropped;
+            }
+            if (report)
+            {
+                finish(file, file->error);
+            }
+            return;
+        }
+
+        file->hasher.update(chunk->buffer, chunk->length);
+        hashed = chunk->length;
+        release(chunk->buffer);
+        delete chunk;
+    }
+}
+
+void SZ_MD5Pipeline::finish(const std::shared_ptr<FileState> &file, const std::string &error)
+{
+    if (file->done.exchange(true))
+    {
+        return;
+    }
+
+    SZ_MD5FileResult result;
+    result.path = file->path;
+    if (error.empty())
+    {
+        result.size = file->size;
+        result.md5 = file->hasher.finalizeStr();
+    }
+    else
+    {
+        result.error = error;
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(callbackMtx_);
+        if (callback_)
+        {
+            callback_(result);
+        }
+    }
+
+    if (--remaining_ == 0)
+    {
+        std::lock_guard<std::mutex> locker(doneMtx_);
+        doneCond_.notify_all();
+    }
+}
+
+void SZ_MD5Pipeline::closeFile(const std::shared_ptr<FileState> &file)
+{
+    if (file->fd >= 0)
+    {
+        ::close(file->fd);
+        file->fd = -1;
+    }
+}
+
+void SZ_MD5Pipeline::release(char *buffer)
+{
+    // 缓冲总数不超过队列容量, push不会失败
+    freeBuffers_.push(buffer);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "SZMD5Batch.h"
+#include "SZThreadPool.h"
+#include "SZThreadQueue.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 异步读取 + 并行计算的多文件MD5流水线
+ *        一个读线程通过io_uring保持大量读请求在途, 读完的数据块交给SZ_ThreadPool计算
+ *        两级之间以固定数量的可复用缓冲块相连, 缓冲用尽时读线程等待计算归还, 内存有界
+ *        同一文件的数据块按偏移顺序计算, 不同文件并行计算
+ *        内核不支持io_uring或不支持IORING_OP_READ(5.6之前)或非Linux平台时, 读线程退回同步pread
+ */
+class SZ_MD5Pipeline : public SZ_Uncopy
+{
+public:
+    typedef std::function<void(const SZ_MD5FileResult &)> Callback;
+
+    struct FileState;
+    struct Chunk;
+
+public:
+    /**
+     * @brief
+     *
+     * @param threads 计算线程数, 为0时取CPU核数
+     * @param depth io_uring队列深度, 即同时在途的读请求数
+     * @param buffers 缓冲块数量, 不小于depth
+     * @param bufferSize 缓冲块大小
+     * @param openFiles 同时打开的文件数上限
+     */
+    explicit SZ_MD5Pipeline(size_t threads = 0, size_t depth = 64, size_t buffers = 128,
+                            size_t bufferSize = 512 * 1024, size_t openFiles = 256);
+
+    ~SZ_MD5Pipeline();
+
+    /**
+     * @brief 计算一组文件, 全部完成后返回
+     *        回调在计算线程或读线程中串行调用
+     *
+     * @param paths
+     * @param callback
+     */
+    void hashFiles(const std::vector<std::string> &paths, const Callback &callback);
+
+    /**
+     * @brief 是否使用io_uring
+     *
+     * @return bool
+     */
+    bool isAsync() const;
+
+protected:
+    /**
+     * @brief 读线程主循环
+     *
+     * @param paths
+     */
+    void readLoop(const std::vector<std::string> &paths);
+
+    /**
+     * @brief 数据块读取完成
+     *
+     * @param chunk
+     * @param result 读取的字节数, 负数为错误码
+     */
+    void onRead(Chunk *chunk, long result);
+
+    /**
+     * @brief 按顺序计算文件已就绪的数据块
+     *
+     * @param file
+     */
+    void drain(std::shared_ptr<FileState> file);
+
+    /**
+     * @brief 报告文件结果, 每个文件只报告一次
+     *
+     * @param file
+     * @param error
+     */
+    void finish(const std::shared_ptr<FileState> &file, const std::string &error);
+
+    /**
+     * @brief 关闭文件, 只在读线程调用: 读线程可能仍持有该文件并以其fd提交读请求
+     *
+     * @param file
+     */
+    void closeFile(const std::shared_ptr<FileState> &file);
+
+    /**
+     * @brief 归还缓冲块
+     *
+     * @param buffer
+     */
+    void release(char *buffer);
+
+private:
+    struct Ring;
+
+    size_t depth_;
+    size_t bufferSize_;
+    size_t openFiles_;
+
+    std::unique_ptr<Ring> ring_;
+    std::vector<char *> vBuffers_;
+    SZ_ThreadQueue<char *> freeBuffers_;
+
+    std::mutex runMtx_;
+    Callback callback_;
+    std::mutex callbackMtx_;
+    std::atomic_size_t remaining_;
+    std::mutex doneMtx_;
+    std::condition_variable doneCond_;
+
+    SZ_ThreadPool pool_;
+};
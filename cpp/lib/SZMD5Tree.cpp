@@ -0,0 +1,276 @@
+#include "SZMD5Tree.h"
+
+#include <fcntl.h>
+#include <future>
+#include <sys/stat.h>
+
+namespace
+{
+    SZ_MD5Tree::Digest leafDigest(const char *buffer, size_t length)
+    {
+        static const unsigned char LEAF_PREFIX = 0x00;
+
+        SZ_MD5Tree::Digest digest;
+        SZ_MD5Hasher hasher;
+        hasher.update(&LEAF_PREFIX, 1);
+        hasher.update(buffer, length);
+        hasher.finalize(digest.bytes.data());
+
+        return digest;
+    }
+
+    /**
+     * @brief 打开文件并取大小, 析构时关闭
+     */
+    struct ChunkFile
+    {
+        int fd;
+        uint64_t size;
+
+        explicit ChunkFile(const std::string &fileName) : fd(-1), size(0)
+        {
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+            struct _stat64 st;
+            if (_stat64(fileName.c_str(), &st) != 0)
+            {
+                throw SZ_MD5_Exception("Can not open file \"" + fileName + "\": " + strerror(errno));
+            }
+#else
+            fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                throw SZ_MD5_Exception("Can not open file \"" + fileName + "\": " + strerror(errno));
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                int err = errno;
+                ::close(fd);
+                throw SZ_MD5_Exception("Stat file \"" + fileName + "\" failed: " + strerror(err));
+            }
+#endif
+            size = static_cast<uint64_t>(st.st_size);
+        }
+
+        ~ChunkFile()
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    };
+
+    /**
+     * @brief 等待全部任务结束后再抛出第一个异常, 保证任务不再访问调用方的数据
+     */
+    std::vector<SZ_MD5Tree::Digest> collect(std::vector<std::future<SZ_MD5Tree::Digest>> &vFutures)
+    {
+        std::vector<SZ_MD5Tree::Digest> vDigests(vFutures.size());
+        std::exception_ptr error;
+        for (size_t i = 0; i < vFutures.size(); ++i)
+        {
+            try
+            {
+                vDigests[i] = vFutures[i].get();
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        return vDigests;
+    }
+}
+
+SZ_MD5Tree::SZ_MD5Tree(size_t threads, uint64_t chunkSize) : chunkSize_(chunkSize > 0 ? chunkSize : 4 * 1024 * 1024)
+{
+    pool_.start(threads);
+}
+
+SZ_MD5Tree::~SZ_MD5Tree()
+{
+    pool_.stop();
+}
+
+uint64_t SZ_MD5Tree::chunkSize() const
+{
+    return chunkSize_;
+}
+
+size_t SZ_MD5Tree::chunkCount(uint64_t size) const
+{
+    return size == 0 ? 1 : static_cast<size_t>((size + chunkSize_ - 1) / chunkSize_);
+}
+
+std::vector<SZ_MD5Tree::Digest> SZ_MD5Tree::leaves(const char *buffer, size_t length)
+{
+    size_t count = chunkCount(length);
+
+    std::vector<std::future<Digest>> vFutures;
+    vFutures.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t offset = i * chunkSize_;
+        size_t n = static_cast<size_t>(std::min<uint64_t>(chunkSize_, length - offset));
+        vFutures.push_back(pool_.insert([buffer, offset, n]()
+                                        { return leafDigest(buffer + offset, n); }));
+    }
+
+    return collect(vFutures);
+}
+
+std::vector<SZ_MD5Tree::Digest> SZ_MD5Tree::fileLeaves(const std::string &fileName)
+{
+    ChunkFile file(fileName);
+
+    size_t count = chunkCount(file.size);
+    std::vector<std::future<Digest>> vFutures;
+    vFutures.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t offset = i * chunkSize_;
+        uint64_t n = std::min<uint64_t>(chunkSize_, file.size - offset);
+        int fd = file.fd;
+        vFutures.push_back(pool_.insert([fd, &fileName, offset, n]()
+                                        { return hashChunk(fd, fileName, offset, n); }));
+    }
+
+    return collect(vFutures);
+}
+
+std::vector<SZ_MD5Tree::Digest> SZ_MD5Tree::fileLeaves(const std::string &fileName, const std::vector<size_t> &indexes)
+{
+    ChunkFile file(fileName);
+
+    size_t count = chunkCount(file.size);
+    for (auto index : indexes)
+    {
+        if (index >= count)
+        {
+            throw SZ_MD5_Exception("Chunk index " + std::to_string(index) + " out of range in \"" + fileName + "\"");
+        }
+    }
+
+    std::vector<std::future<Digest>> vFutures;
+    vFutures.reserve(indexes.size());
+    for (auto index : indexes)
+    {
+        uint64_t offset = index * chunkSize_;
+        uint64_t n = std::min<uint64_t>(chunkSize_, file.size - offset);
+        int fd = file.fd;
+        vFutures.push_back(pool_.insert([fd, &fileName, offset, n]()
+                                        { return hashChunk(fd, fileName, offset, n); }));
+    }
+
+    return collect(vFutures);
+}
+
+std::string SZ_MD5Tree::hashFile(const std::string &fileName, std::vector<Digest> *vLeaves)
+{
+    std::vector<Digest> vDigests = fileLeaves(fileName);
+    std::string s = rootStr(vDigests);
+    if (nullptr != vLeaves)
+    {
+        vLeaves->swap(vDigests);
+    }
+
+    return s;
+}
+
+std::string SZ_MD5Tree::hash(const char *buffer, size_t length, std::vector<Digest> *vLeaves)
+{
+    std::vector<Digest> vDigests = leaves(buffer, length);
+    std::string s = rootStr(vDigests);
+    if (nullptr != vLeaves)
+    {
+        vLeaves->swap(vDigests);
+    }
+
+    return s;
+}
+
+std::vector<size_t> SZ_MD5Tree::diff(const std::string &fileName, const std::vector<Digest> &expected)
+{
+    std::vector<Digest> vDigests = fileLeaves(fileName);
+
+    std::vector<size_t> vChanged;
+    size_t count = std::max(vDigests.size(), expected.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i >= vDigests.size() || i >= expected.size() || vDigests[i] != expected[i])
+        {
+            vChanged.push_back(i);
+        }
+    }
+
+    return vChanged;
+}
+
+SZ_MD5Tree::Digest SZ_MD5Tree::root(const std::vector<Digest> &vLeaves)
+{
+    static const unsigned char NODE_PREFIX = 0x01;
+
+    if (vLeaves.empty())
+    {
+        return leafDigest(nullptr, 0);
+    }
+
+    std::vector<Digest> vLevel(vLeaves);
+    while (vLevel.size() > 1)
+    {
+        size_t half = vLevel.size() / 2;
+        for (size_t i = 0; i < half; ++i)
+        {
+            SZ_MD5Hasher hasher;
+            hasher.update(&NODE_PREFIX, 1);
+            hasher.update(vLevel[2 * i].bytes.data(), vLevel[2 * i].bytes.size());
+            hasher.update(vLevel[2 * i + 1].bytes.data(), vLevel[2 * i + 1].bytes.size());
+            hasher.finalize(vLevel[i].bytes.data());
+        }
+        if (vLevel.size() % 2 != 0)
+        {
+            vLevel[half] = vLevel.back();
+            ++half;
+        }
+        vLevel.resize(half);
+    }
+
+    return vLevel[0];
+}
+
+std::string SZ_MD5Tree::rootStr(const std::vector<Digest> &vLeaves)
+{
+    return root(vLeaves).str();
+}
+
+SZ_MD5Tree::Digest SZ_MD5Tree::hashChunk(int fd, const std::string &fileName, uint64_t offset, uint64_t length)
+{
+    static const unsigned char LEAF_PREFIX = 0x00;
+
+    SZ_MD5Hasher hasher;
+    hasher.update(&LEAF_PREFIX, 1);
+
+    std::string sErr;
+    if (!SZ_MD5::readRange(fd, fileName, offset, length, [&hasher](const unsigned char *data, size_t n)
+                           { hasher.update(data, n); },
+                           sErr))
+    {
+        throw SZ_MD5_Exception(sErr);
+    }
+
+    Digest digest;
+    hasher.finalize(digest.bytes.data());
+
+    return digest;
+}
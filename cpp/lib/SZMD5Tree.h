@@ -0,0 +1,134 @@
+#pragma once
+
+#include "SZMD5.h"
+#include "SZThreadPool.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief 分块MD5哈希树
+ *        输入按固定大小分块, 各块在SZ_ThreadPool上并行计算叶子摘要, 再两两合并为根摘要
+ *        叶子为MD5(0x00 || 块数据), 内部节点为MD5(0x01 || 左 || 右), 奇数个节点时末尾节点直接上提
+ *        空输入视为一个空块
+ *        保存叶子摘要后, 可只重算指定块或找出变化的块, 无需整体重算
+ *        根摘要与对整个文件计算MD5的结果不同, 两者不可混用
+ */
+class SZ_MD5Tree : public SZ_Uncopy
+{
+public:
+    typedef SZ_MD5Digest Digest;
+
+public:
+    /**
+     * @brief
+     *
+     * @param threads 工作线程数, 为0时取CPU核数
+     * @param chunkSize 块大小
+     */
+    explicit SZ_MD5Tree(size_t threads = 0, uint64_t chunkSize = 4 * 1024 * 1024);
+
+    ~SZ_MD5Tree();
+
+    /**
+     * @brief 块大小
+     *
+     * @return uint64_t
+     */
+    uint64_t chunkSize() const;
+
+    /**
+     * @brief 并行计算缓冲区的全部叶子摘要
+     *
+     * @param buffer
+     * @param length
+     * @return std::vector<Digest>
+     */
+    std::vector<Digest> leaves(const char *buffer, size_t length);
+
+    /**
+     * @brief 并行计算文件的全部叶子摘要
+     *
+     * @param fileName
+     * @return std::vector<Digest>
+     */
+    std::vector<Digest> fileLeaves(const std::string &fileName);
+
+    /**
+     * @brief 并行计算文件指定块的叶子摘要
+     *
+     * @param fileName
+     * @param indexes 块序号
+     * @return std::vector<Digest> 与indexes一一对应
+     */
+    std::vector<Digest> fileLeaves(const std::string &fileName, const std::vector<size_t> &indexes);
+
+    /**
+     * @brief 根摘要, 32位十六进制数
+     *
+     * @param fileName
+     * @param vLeaves 非空时输出叶子摘要
+     * @return std::string
+     */
+    std::string hashFile(const std::string &fileName, std::vector<Digest> *vLeaves = nullptr);
+
+    /**
+     * @brief 根摘要, 32位十六进制数
+     *
+     * @param buffer
+     * @param length
+     * @param vLeaves 非空时输出叶子摘要
+     * @return std::string
+     */
+    std::string hash(const char *buffer, size_t length, std::vector<Digest> *vLeaves = nullptr);
+
+    /**
+     * @brief 与已保存的叶子摘要比较, 找出内容变化的块
+     *        文件变长或变短时, 多出或缺少的块也计入
+     *
+     * @param fileName
+     * @param expected
+     * @return std::vector<size_t> 变化的块序号, 升序
+     */
+    std::vector<size_t> diff(const std::string &fileName, const std::vector<Digest> &expected);
+
+    /**
+     * @brief 由叶子摘要计算根摘要
+     *
+     * @param vLeaves
+     * @return Digest
+     */
+    static Digest root(const std::vector<Digest> &vLeaves);
+
+    /**
+     * @brief 由叶子摘要计算根摘要, 32位十六进制数
+     *
+     * @param vLeaves
+     * @return std::string
+     */
+    static std::string rootStr(const std::vector<Digest> &vLeaves);
+
+protected:
+    /**
+     * @brief 计算文件中一个块的叶子摘要
+     *
+     * @param fd
+     * @param fileName
+     * @param offset
+     * @param length
+     * @return Digest
+     */
+    static Digest hashChunk(int fd, const std::string &fileName, uint64_t offset, uint64_t length);
+
+    /**
+     * @brief 块数量
+     *
+     * @param size
+     * @return size_t
+     */
+    size_t chunkCount(uint64_t size) const;
+
+private:
+    uint64_t chunkSize_;
+    SZ_ThreadPool pool_;
+};
@@ -1,16 +1,8 @@
 #include "SZMysql.h"
+#include "SZMysqlStmt.h"
 
 #if defined SZ_USE_MYSQL
 
-static std::string mysqlError(MYSQL *mysqlHandle)
-{
-    std::string str;
-    str += std::string("code:") + SZ_Common::toString(mysql_errno(mysqlHandle));
-    str += std::string(", message: ") + mysql_error(mysqlHandle);
-    str += std::string(", status: ") + mysql_sqlstate(mysqlHandle);
-    return str;
-}
-
 void SZ_DBConfig::loadConfig(const std::map<std::string, std::string> &mapConfig)
 {
     auto mConf = mapConfig;
@@ -50,6 +42,215 @@ std::ostream &operator<<(std::ostream &os, const SZ_DBConfig &config)
     return os;
 }
 
+SZ_DBValue SZ_DBValue::blob(const void *data, size_t length)
+{
+    SZ_DBValue value;
+    value.type_ = TYPE_BLOB;
+    value.str_.assign(static_cast<const char *>(data), length);
+    return value;
+}
+
+int64_t SZ_DBValue::toInt() const
+{
+    switch (type_)
+    {
+    case TYPE_INT:
+        return num_.i;
+    case TYPE_UINT:
+        return static_cast<int64_t>(num_.u);
+    case TYPE_DOUBLE:
+        return static_cast<int64_t>(num_.d);
+    case TYPE_STRING:
+    case TYPE_BLOB:
+        return strtoll(str_.c_str(), nullptr, 10);
+    default:
+        return 0;
+    }
+}
+
+uint64_t SZ_DBValue::toUInt() const
+{
+    switch (type_)
+    {
+    case TYPE_INT:
+        return static_cast<uint64_t>(num_.i);
+    case TYPE_UINT:
+        return num_.u;
+    case TYPE_DOUBLE:
+        return static_cast<uint64_t>(num_.d);
+    case TYPE_STRING:
+    case TYPE_BLOB:
+        return strtoull(str_.c_str(), nullptr, 10);
+    default:
+        return 0;
+    }
+}
+
+double SZ_DBValue::toDouble() const
+{
+    switch (type_)
+    {
+    case TYPE_INT:
+        return static_cast<double>(num_.i);
+    case TYPE_UINT:
+        return static_cast<double>(num_.u);
+    case TYPE_DOUBLE:
+        return num_.d;
+    case TYPE_STRING:
+    case TYPE_BLOB:
+        return strtod(str_.c_str(), nullptr);
+    default:
+        return 0;
+    }
+}
+
+std::string SZ_DBValue::toString() const
+{
+    switch (type_)
+    {
+    case TYPE_INT:
+        return std::to_string(num_.i);
+    case TYPE_UINT:
+        return std::to_string(num_.u);
+    case TYPE_DOUBLE:
+    {
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), "%.17g", num_.d);
+        return std::string(buf, n);
+    }
+    case TYPE_STRING:
+    case TYPE_BLOB:
+        return str_;
+    default:
+        return std::string();
+    }
+}
+
+const void *SZ_DBValue::data() const
+{
+    return TYPE_STRING == type_ || TYPE_BLOB == type_ ? static_cast<const void *>(str_.data()) : static_cast<const void *>(&num_);
+}
+
+size_t SZ_DBValue::size() const
+{
+    switch (type_)
+    {
+    case TYPE_NULL:
+        return 0;
+    case TYPE_STRING:
+    case TYPE_BLOB:
+        return str_.size();
+    default:
+        return sizeof(num_);
+    }
+}
+
+SZ_DBTable::SZ_DBTable() : columns_(std::make_shared<Columns>()), vOffsets_(1, 0)
+{
+}
+
+void SZ_DBTable::setFields(const std::vector<std::string> &vFields)
+{
+    std::shared_ptr<Columns> columns = std::make_shared<Columns>();
+    columns->vNames = vFields;
+    for (size_t i = 0; i < vFields.size(); ++i)
+    {
+        // 重名列按第一次出现的位置
+        columns->mapIndex.insert(std::make_pair(vFields[i], i));
+    }
+    columns_ = columns;
+
+    vArena_.clear();
+    vOffsets_.assign(1, 0);
+    vNulls_.clear();
+}
+
+void SZ_DBTable::reserve(size_t rows, size_t bytes)
+{
+    size_t cells = rows * cols();
+    vOffsets_.reserve(cells + 1);
+    vNulls_.reserve(cells);
+    if (bytes > 0)
+    {
+        vArena_.reserve(bytes);
+    }
+}
+
+void SZ_DBTable::appendRow(const SZ_DBCell *cells)
+{
+    for (size_t i = 0; i < cols(); ++i)
+    {
+        const SZ_DBCell &cell = cells[i];
+        if (!cell.isNull())
+        {
+            vArena_.insert(vArena_.end(), cell.data, cell.data + cell.length);
+        }
+        vOffsets_.push_back(vArena_.size());
+        vNulls_.push_back(cell.isNull());
+    }
+}
+
+void SZ_DBTable::appendRow(const SZ_DBCursor &cursor)
+{
+    for (size_t i = 0; i < cols(); ++i)
+    {
+        SZ_DBCell cell = cursor[i];
+        if (!cell.isNull())
+        {
+            vArena_.insert(vArena_.end(), cell.data, cell.data + cell.length);
+        }
+        vOffsets_.push_back(vArena_.size());
+        vNulls_.push_back(cell.isNull());
+    }
+}
+
+const std::vector<std::string> &SZ_DBTable::fields() const
+{
+    return columns_->vNames;
+}
+
+size_t SZ_DBTable::index(const std::string &field) const
+{
+    auto it = columns_->mapIndex.find(field);
+    if (it == columns_->mapIndex.end())
+    {
+        throw SZ_Mysql_Exception("Field not found: \"" + field + "\"");
+    }
+
+    return it->second;
+}
+
+size_t SZ_DBTable::rows() const
+{
+    return cols() == 0 ? 0 : vNulls_.size() / cols();
+}
+
+size_t SZ_DBTable::cols() const
+{
+    return columns_->vNames.size();
+}
+
+SZ_DBCell SZ_DBTable::at(size_t row, size_t col) const
+{
+    if (row >= rows() || col >= cols())
+    {
+        throw SZ_Mysql_Exception("Cell (" + SZ_Common::toString(row) + ", " + SZ_Common::toString(col) + ") out of range");
+    }
+
+    return cell(row, col);
+}
+
+size_t SZ_DBTable::memory() const
+{
+    size_t bytes = sizeof(*this) + vArena_.capacity() + vOffsets_.capacity() * sizeof(size_t) + vNulls_.capacity() / 8;
+    for (auto &name : columns_->vNames)
+    {
+        bytes += sizeof(name) + name.capacity() + sizeof(size_t) * 4;
+    }
+
+    return bytes;
+}
+
 SZ_DBResult::SZ_DBRow::SZ_DBRow(const std::map<std::string, std::string> &row) : row_(row)
 {
 }
@@ -91,12 +292,132 @@ SZ_DBResult::SZ_DBRow SZ_DBResult::operator[](size_t i)
     return SZ_DBRow(result_[i]);
 }
 
-SZ_Mysql::SZ_Mysql() : isConnect_(false), handle_(nullptr)
+SZ_DBCursor::SZ_DBCursor(MYSQL *handle, MYSQL_RES *result, const std::string &sSql)
+    : handle_(handle), result_(result), sql_(sSql), row_(nullptr), lengths_(nullptr), rows_(0)
+{
+    MYSQL_FIELD *field;
+    while ((field = mysql_fetch_field(result_)))
+    {
+        vFields_.emplace_back(field->name);
+    }
+}
+
+SZ_DBCursor::SZ_DBCursor(SZ_DBCursor &&other) noexcept
+    : handle_(other.handle_), result_(other.result_), sql_(std::move(other.sql_)), vFields_(std::move(other.vFields_)),
+      row_(other.row_), lengths_(other.lengths_), rows_(other.rows_)
+{
+    other.result_ = nullptr;
+    other.row_ = nullptr;
+}
+
+SZ_DBCursor &SZ_DBCursor::operator=(SZ_DBCursor &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        handle_ = other.handle_;
+        result_ = other.result_;
+        sql_ = std::move(other.sql_);
+        vFields_ = std::move(other.vFields_);
+        row_ = other.row_;
+        lengths_ = other.lengths_;
+        rows_ = other.rows_;
+        other.result_ = nullptr;
+        other.row_ = nullptr;
+    }
+
+    return *this;
+}
+
+SZ_DBCursor::~SZ_DBCursor()
+{
+    close();
+}
+
+bool SZ_DBCursor::next()
+{
+    if (nullptr == result_)
+    {
+        return false;
+    }
+
+    row_ = mysql_fetch_row(result_);
+    if (nullptr == row_)
+    {
+        // 流式读取时取不到行既可能是读完, 也可能是网络出错
+        if (mysql_errno(handle_) != 0)
+        {
+            std::string sErr = SZ_Mysql::mysqlError(handle_);
+            close();
+            throw SZ_Mysql_Exception("mysql_fetch_row: [" + sql_ + "] [" + sErr + "]");
+        }
+        close();
+        return false;
+    }
+
+    lengths_ = mysql_fetch_lengths(result_);
+    ++rows_;
+    return true;
+}
+
+const std::vector<std::string> &SZ_DBCursor::fields() const
+{
+    return vFields_;
+}
+
+size_t SZ_DBCursor::index(const std::string &field) const
+{
+    for (size_t i = 0; i < vFields_.size(); ++i)
+    {
+        if (vFields_[i] == field)
+        {
+            return i;
+        }
+    }
+
+    throw SZ_Mysql_Exception("Field not found: \"" + field + "\"");
+}
+
+SZ_DBCell SZ_DBCursor::operator[](size_t col) const
+{
+    if (nullptr == row_ || col >= vFields_.size())
+    {
+        throw SZ_Mysql_Exception("Column index " + SZ_Common::toString(col) + " out of range: [" + sql_ + "]");
+    }
+
+    return SZ_DBCell(row_[col], lengths_[col]);
+}
+
+SZ_DBCell SZ_DBCursor::operator[](const std::string &field) const
+{
+    return (*this)[index(field)];
+}
+
+uint64_t SZ_DBCursor::rows() const
+{
+    return rows_;
+}
+
+void SZ_DBCursor::close()
+{
+    if (nullptr != result_)
+    {
+        mysql_free_result(result_);
+        result_ = nullptr;
+    }
+    row_ = nullptr;
+}
+
+SZ_Mysql::SZ_Mysql() : isConnect_(false), handle_(nullptr), generation_(0), stmtCacheSize_(128)
 {
 }
 
 SZ_Mysql::~SZ_Mysql()
 {
+    // 预处理语句须在连接关闭前释放
+    mapStmts_.clear();
+    lstStmts_.clear();
+
     if (nullptr != handle_)
     {
         mysql_close(handle_);
@@ -177,6 +498,7 @@ void SZ_Mysql::connect()
     }
 
     isConnect_ = true;
+    ++generation_;
 }
 
 void SZ_Mysql::disconnect()
@@ -189,6 +511,31 @@ void SZ_Mysql::disconnect()
     isConnect_ = false;
 }
 
+bool SZ_Mysql::ping()
+{
+    if (!isConnect_ || nullptr == handle_)
+    {
+        return false;
+    }
+
+    return mysql_ping(handle_) == 0;
+}
+
+bool SZ_Mysql::isConnected() const
+{
+    return isConnect_;
+}
+
+uint64_t SZ_Mysql::generation() const
+{
+    return generation_;
+}
+
+const SZ_DBConfig &SZ_Mysql::config() const
+{
+    return config_;
+}
+
 MYSQL *SZ_Mysql::handle()
 {
     return handle_;
@@ -196,28 +543,9 @@ MYSQL *SZ_Mysql::handle()
 
 SZ_DBResult SZ_Mysql::query(const std::string &sSql)
 {
-    if (!isConnect_)
-    {
-        connect();
-    }
-
     SZ_DBResult dbResult;
 
-    int iRet = mysql_real_query(handle_, sSql.c_str(), sSql.length());
-    if (iRet != 0)
-    {
-        int iErrno = mysql_errno(handle_);
-        if (iErrno == 2013 || iErrno == 2006)
-        {
-            connect();
-            iRet = mysql_real_query(handle_, sSql.c_str(), sSql.length());
-        }
-    }
-
-    if (iRet != 0)
-    {
-        throw SZ_Mysql_Exception("mysql_real_query: [ " + sSql + " ] [" + mysqlError(handle_) + "]");
-    }
+    realQuery(sSql);
 
     MYSQL_RES *result = mysql_store_result(handle_);
 
@@ -260,20 +588,64 @@ SZ_DBResult SZ_Mysql::query(const std::string &sSql)
     return dbResult;
 }
 
+SZ_DBCursor SZ_Mysql::queryCursor(const std::string &sSql)
+{
+    realQuery(sSql);
+
+    MYSQL_RES *result = mysql_use_result(handle_);
+    if (nullptr == result)
+    {
+        throw SZ_Mysql_Exception("mysql_use_result: [" + sSql + "] [" + mysqlError(handle_) + "]");
+    }
+
+    return SZ_DBCursor(handle_, result, sSql);
+}
+
+uint64_t SZ_Mysql::queryEach(const std::string &sSql, const std::function<bool(const SZ_DBCursor &)> &callback)
+{
+    SZ_DBCursor cursor = queryCursor(sSql);
+    while (cursor.next())
+    {
+        if (!callback(cursor))
+        {
+            break;
+        }
+    }
+
+    return cursor.rows();
+}
+
+SZ_DBTable SZ_Mysql::queryTable(const std::string &sSql)
+{
+    SZ_DBCursor cursor = queryCursor(sSql);
+
+    SZ_DBTable table;
+    table.setFields(cursor.fields());
+    while (cursor.next())
+    {
+        table.appendRow(cursor);
+    }
+
+    return table;
+}
+
 void SZ_Mysql::execute(const std::string &sSql)
+{
+    realQuery(sSql);
+}
+
+void SZ_Mysql::realQuery(const std::string &sSql)
 {
     if (!isConnect_)
     {
         connect();
     }
 
-    SZ_DBResult dbResult;
-
     int iRet = mysql_real_query(handle_, sSql.c_str(), sSql.length());
     if (iRet != 0)
     {
         int iErrno = mysql_errno(handle_);
-        if (iErrno == 2013 || iErrno == 2006)
+        if (isConnectionLost(iErrno))
         {
             connect();
             iRet = mysql_real_query(handle_, sSql.c_str(), sSql.length());
@@ -304,6 +676,138 @@ size_t SZ_Mysql::executeDelete(const std::string &sSql)
     return mysql_affected_rows(handle_);
 }
 
+std::vector<SZ_DBStatementResult> SZ_Mysql::executeMulti(const std::vector<std::string> &vSqls)
+{
+    std::vector<SZ_DBStatementResult> vResults;
+    if (vSqls.empty())
+    {
+        return vResults;
+    }
+
+    // 去掉各语句末尾的分号与空白后以分号连接
+    std::string sSql;
+    for (size_t i = 0; i < vSqls.size(); ++i)
+    {
+        size_t end = vSqls[i].find_last_not_of("; \t\r\n");
+        if (std::string::npos == end)
+        {
+            throw SZ_Mysql_Exception("executeMulti: statement " + SZ_Common::toString(i) + " is empty");
+        }
+        if (i > 0)
+        {
+            sSql += ';';
+        }
+        sSql.append(vSqls[i], 0, end + 1);
+    }
+
+    if (!isConnect_)
+    {
+        connect();
+    }
+
+    // 连接未开启多语句时临时开启, 重连后服务端选项恢复默认, 须重新开启
+    // 只在确定语句未发出时重连重试一次: 开启多语句时断开, 或发送时连接已不在(2006)
+    // 执行中断开(2013)时部分语句可能已执行, 重发会重复执行, 直接报错
+    bool toggle = 0 == (config_.clientFlag & CLIENT_MULTI_STATEMENTS);
+    int iRet = 0;
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (attempt > 0)
+        {
+            connect();
+        }
+        if (toggle && mysql_set_server_option(handle_, MYSQL_OPTION_MULTI_STATEMENTS_ON) != 0)
+        {
+            if (0 == attempt && isConnectionLost(mysql_errno(handle_)))
+            {
+                continue;
+            }
+            throw SZ_Mysql_Exception("mysql_set_server_option MYSQL_OPTION_MULTI_STATEMENTS_ON: [" + mysqlError(handle_) + "]");
+        }
+
+        iRet = mysql_real_query(handle_, sSql.c_str(), sSql.length());
+        if (0 == attempt && iRet != 0 && mysql_errno(handle_) == 2006)
+        {
+            continue;
+        }
+        break;
+    }
+
+    // 第一条语句出错时mysql_real_query即返回错误, 之后的语句出错时mysql_next_result返回错误
+    size_t index = 0;
+    unsigned int iErrno = 0;
+    std::string sErr;
+    bool storeFailed = false;
+    while (0 == iRet)
+    {
+        SZ_DBStatementResult result;
+        result.index = index;
+
+        MYSQL_RES *res = mysql_store_result(handle_);
+        if (nullptr != res)
+        {
+            SZ_DBCursor cursor(handle_, res, index < vSqls.size() ? vSqls[index] : sSql);
+            result.hasResult = true;
+            result.table.setFields(cursor.fields());
+            while (cursor.next())
+            {
+                result.table.appendRow(cursor);
+            }
+        }
+        else if (mysql_field_count(handle_) != 0)
+        {
+            iRet = -1;
+            storeFailed = true;
+            break;
+        }
+
+        result.affectedRows = result.hasResult ? result.table.rows() : mysql_affected_rows(handle_);
+        result.lastInsertId = mysql_insert_id(handle_);
+        result.warnings = mysql_warning_count(handle_);
+        vResults.push_back(std::move(result));
+
+        if (!mysql_more_results(handle_))
+        {
+            break;
+        }
+        ++index;
+        iRet = mysql_next_result(handle_);
+    }
+
+    if (iRet != 0)
+    {
+        iErrno = mysql_errno(handle_);
+        sErr = mysqlError(handle_);
+    }
+
+    // 取结果失败时之后的结果无法再读出, 连接停在commands out of sync, 断开以免影响下一次使用
+    if (storeFailed)
+    {
+        disconnect();
+    }
+
+    if (toggle && isConnect_ && !isConnectionLost(iErrno) && mysql_set_server_option(handle_, MYSQL_OPTION_MULTI_STATEMENTS_OFF) != 0)
+    {
+        // 关闭失败则断开, 避免其他语句在开启多语句的连接上执行
+        disconnect();
+    }
+
+    if (iRet != 0)
+    {
+        const std::string &sStatement = index < vSqls.size() ? vSqls[index] : sSql;
+        throw SZ_Mysql_StatementException("mysql_real_query: statement " + SZ_Common::toString(index) + " [ " + sStatement + " ] [" + sErr + "]", index,
+                                          iErrno, std::move(vResults));
+    }
+
+    if (vResults.size() != vSqls.size())
+    {
+        throw SZ_Mysql_Exception("executeMulti: expect " + SZ_Common::toString(vSqls.size()) + " results, got " + SZ_Common::toString(vResults.size()) +
+                                 ", a statement may contain more than one statement");
+    }
+
+    return vResults;
+}
+
 size_t SZ_Mysql::affectedRows()
 {
     return mysql_affected_rows(handle_);
@@ -326,4 +830,50 @@ std::string SZ_Mysql::escapeString(const std::string &sFrom)
     return sTo;
 }
 
+std::shared_ptr<SZ_MysqlStmt> SZ_Mysql::prepare(const std::string &sSql)
+{
+    auto it = mapStmts_.find(sSql);
+    if (it != mapStmts_.end())
+    {
+        lstStmts_.splice(lstStmts_.begin(), lstStmts_, it->second);
+        return lstStmts_.front();
+    }
+
+    std::shared_ptr<SZ_MysqlStmt> stmt = std::make_shared<SZ_MysqlStmt>(this, sSql);
+    lstStmts_.push_front(stmt);
+    mapStmts_[sSql] = lstStmts_.begin();
+
+    while (lstStmts_.size() > stmtCacheSize_)
+    {
+        mapStmts_.erase(lstStmts_.back()->sql());
+        lstStmts_.pop_back();
+    }
+
+    return stmt;
+}
+
+void SZ_Mysql::setStmtCacheSize(size_t size)
+{
+    stmtCacheSize_ = std::max<size_t>(1, size);
+    while (lstStmts_.size() > stmtCacheSize_)
+    {
+        mapStmts_.erase(lstStmts_.back()->sql());
+        lstStmts_.pop_back();
+    }
+}
+
+std::string SZ_Mysql::mysqlError(MYSQL *mysqlHandle)
+{
+    std::string str;
+    str += std::string("code:") + SZ_Common::toString(mysql_errno(mysqlHandle));
+    str += std::string(", message: ") + mysql_error(mysqlHandle);
+    str += std::string(", status: ") + mysql_sqlstate(mysqlHandle);
+    return str;
+}
+
+bool SZ_Mysql::isConnectionLost(unsigned int iErrno)
+{
+    return iErrno == 2013 || iErrno == 2006;
+}
+
 #endif // SZ_USE_MYSQL
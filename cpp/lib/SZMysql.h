@@ -4,6 +4,8 @@
 
 #include "SZUtility.h"
 
+#include <functional>
+
 class SZ_Mysql_Exception : public SZ_Exception
 {
 public:
@@ -37,6 +39,345 @@ struct SZ_DBConfig
 	friend std::ostream &operator<<(std::ostream &os, const SZ_DBConfig &config);
 };
 
+/**
+ * @brief 带类型的数据库值, 用于参数绑定
+ */
+class SZ_DBValue
+{
+public:
+	enum Type
+	{
+		TYPE_NULL,
+		TYPE_INT,
+		TYPE_UINT,
+		TYPE_DOUBLE,
+		TYPE_STRING,
+		TYPE_BLOB,
+	};
+
+public:
+	SZ_DBValue() : type_(TYPE_NULL) { num_.i = 0; }
+	SZ_DBValue(int v) : type_(TYPE_INT) { num_.i = v; }
+	SZ_DBValue(long v) : type_(TYPE_INT) { num_.i = v; }
+	SZ_DBValue(long long v) : type_(TYPE_INT) { num_.i = v; }
+	SZ_DBValue(unsigned int v) : type_(TYPE_UINT) { num_.u = v; }
+	SZ_DBValue(unsigned long v) : type_(TYPE_UINT) { num_.u = v; }
+	SZ_DBValue(unsigned long long v) : type_(TYPE_UINT) { num_.u = v; }
+	SZ_DBValue(double v) : type_(TYPE_DOUBLE) { num_.d = v; }
+	SZ_DBValue(const char *v) : type_(TYPE_STRING), str_(v) { num_.i = 0; }
+	SZ_DBValue(const std::string &v) : type_(TYPE_STRING), str_(v) { num_.i = 0; }
+	SZ_DBValue(std::string &&v) : type_(TYPE_STRING), str_(std::move(v)) { num_.i = 0; }
+
+	/**
+	 * @brief 二进制数据
+	 *
+	 * @param data
+	 * @param length
+	 * @return SZ_DBValue
+	 */
+	static SZ_DBValue blob(const void *data, size_t length);
+
+	Type type() const { return type_; }
+	bool isNull() const { return TYPE_NULL == type_; }
+
+	/**
+	 * @brief 转为整数, 字符串按十进制解析
+	 *
+	 * @return int64_t
+	 */
+	int64_t toInt() const;
+
+	/**
+	 * @brief 转为无符号整数
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t toUInt() const;
+
+	/**
+	 * @brief 转为浮点数
+	 *
+	 * @return double
+	 */
+	double toDouble() const;
+
+	/**
+	 * @brief 转为字符串, NULL为空串, 浮点数保留17位有效数字
+	 *
+	 * @return std::string
+	 */
+	std::string toString() const;
+
+	/**
+	 * @brief 数值的存储地址, 字符串或二进制数据的首地址
+	 *
+	 * @return const void*
+	 */
+	const void *data() const;
+
+	/**
+	 * @brief 字符串或二进制数据的长度, 数值为其字节数
+	 *
+	 * @return size_t
+	 */
+	size_t size() const;
+
+private:
+	Type type_;
+	union
+	{
+		int64_t i;
+		uint64_t u;
+		double d;
+	} num_;
+	std::string str_;
+};
+
+class SZ_MysqlStmt;
+
+/**
+ * @brief 单元格, 指向客户端库的行缓冲, 读取下一行后失效
+ */
+struct SZ_DBCell
+{
+	const char *data; // NULL值为nullptr
+	size_t length;
+
+	SZ_DBCell() : data(nullptr), length(0) {}
+	SZ_DBCell(const char *d, size_t n) : data(d), length(n) {}
+
+	bool isNull() const { return nullptr == data; }
+
+	/**
+	 * @brief 拷贝为字符串, NULL为空串
+	 *
+	 * @return std::string
+	 */
+	std::string str() const { return nullptr == data ? std::string() : std::string(data, length); }
+};
+
+/**
+ * @brief 流式结果游标, 基于mysql_use_result逐行从网络读取, 不缓存整个结果集
+ *        游标存活期间所属连接不能执行其他语句; 读取过慢可能触发服务端net_write_timeout
+ *        析构时未读完的行由客户端库读取丢弃
+ */
+class SZ_DBCursor
+{
+public:
+	SZ_DBCursor(SZ_DBCursor &&other) noexcept;
+
+	SZ_DBCursor &operator=(SZ_DBCursor &&other) noexcept;
+
+	SZ_DBCursor(const SZ_DBCursor &) = delete;
+
+	SZ_DBCursor &operator=(const SZ_DBCursor &) = delete;
+
+	~SZ_DBCursor();
+
+	/**
+	 * @brief 读取下一行
+	 *
+	 * @return bool 没有更多行时返回false, 读取出错时抛出SZ_Mysql_Exception
+	 */
+	bool next();
+
+	/**
+	 * @brief 列名
+	 *
+	 * @return const std::vector<std::string>&
+	 */
+	const std::vector<std::string> &fields() const;
+
+	/**
+	 * @brief 列名对应的序号, 循环外解析一次后按序号取值
+	 *
+	 * @param field
+	 * @return size_t 不存在时抛出SZ_Mysql_Exception
+	 */
+	size_t index(const std::string &field) const;
+
+	/**
+	 * @brief 当前行的列
+	 *
+	 * @param col
+	 * @return SZ_DBCell
+	 */
+	SZ_DBCell operator[](size_t col) const;
+
+	/**
+	 * @brief 当前行的列, 每次调用按名字查找
+	 *
+	 * @param field
+	 * @return SZ_DBCell
+	 */
+	SZ_DBCell operator[](const std::string &field) const;
+
+	/**
+	 * @brief 已读取的行数
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t rows() const;
+
+	/**
+	 * @brief 提前释放结果集
+	 */
+	void close();
+
+private:
+	friend class SZ_Mysql;
+
+	SZ_DBCursor(MYSQL *handle, MYSQL_RES *result, const std::string &sSql);
+
+	MYSQL *handle_;
+	MYSQL_RES *result_;
+	std::string sql_;
+	std::vector<std::string> vFields_;
+	MYSQL_ROW row_;
+	unsigned long *lengths_;
+	uint64_t rows_;
+};
+
+/**
+ * @brief 列式存储的结果集
+ *        列名表只建一次, 多个结果集之间可共享; 所有单元格数据连续存放在一块缓冲中, 按偏移与长度访问
+ *        每个单元格只占一个偏移量和一个NULL标志位, 没有逐行逐格的堆分配
+ *        取到的SZ_DBCell在继续追加行之前有效
+ */
+class SZ_DBTable
+{
+public:
+	/**
+	 * @brief 行视图
+	 */
+	class Row
+	{
+	public:
+		Row(const SZ_DBTable *table, size_t row) : table_(table), row_(row) {}
+
+		SZ_DBCell operator[](size_t col) const { return table_->cell(row_, col); }
+
+		SZ_DBCell operator[](const std::string &field) const { return table_->cell(row_, table_->index(field)); }
+
+		size_t size() const { return table_->cols(); }
+
+	private:
+		const SZ_DBTable *table_;
+		size_t row_;
+	};
+
+public:
+	SZ_DBTable();
+
+	/**
+	 * @brief 设置列名, 清空已有数据
+	 *
+	 * @param vFields
+	 */
+	void setFields(const std::vector<std::string> &vFields);
+
+	/**
+	 * @brief 预留空间
+	 *
+	 * @param rows 行数
+	 * @param bytes 单元格数据总字节数
+	 */
+	void reserve(size_t rows, size_t bytes = 0);
+
+	/**
+	 * @brief 追加一行, 单元格个数须与列数相同
+	 *
+	 * @param cells
+	 */
+	void appendRow(const SZ_DBCell *cells);
+
+	/**
+	 * @brief 追加游标的当前行
+	 *
+	 * @param cursor
+	 */
+	void appendRow(const SZ_DBCursor &cursor);
+
+	/**
+	 * @brief 列名
+	 *
+	 * @return const std::vector<std::string>&
+	 */
+	const std::vector<std::string> &fields() const;
+
+	/**
+	 * @brief 列名对应的序号, 哈希查找
+	 *
+	 * @param field
+	 * @return size_t 不存在时抛出SZ_Mysql_Exception
+	 */
+	size_t index(const std::string &field) const;
+
+	/**
+	 * @brief 行数
+	 *
+	 * @return size_t
+	 */
+	size_t rows() const;
+
+	/**
+	 * @brief 列数
+	 *
+	 * @return size_t
+	 */
+	size_t cols() const;
+
+	bool empty() const { return 0 == rows(); }
+
+	/**
+	 * @brief 单元格, 不检查越界
+	 *
+	 * @param row
+	 * @param col
+	 * @return SZ_DBCell
+	 */
+	SZ_DBCell cell(size_t row, size_t col) const
+	{
+		size_t i = row * cols() + col;
+		if (vNulls_[i])
+		{
+			return SZ_DBCell();
+		}
+		// 缓冲为空时data()可能为nullptr, 空串不能被当作NULL
+		return SZ_DBCell(vArena_.empty() ? "" : vArena_.data() + vOffsets_[i], vOffsets_[i + 1] - vOffsets_[i]);
+	}
+
+	/**
+	 * @brief 单元格, 越界时抛出SZ_Mysql_Exception
+	 *
+	 * @param row
+	 * @param col
+	 * @return SZ_DBCell
+	 */
+	SZ_DBCell at(size_t row, size_t col) const;
+
+	Row operator[](size_t row) const { return Row(this, row); }
+
+	/**
+	 * @brief 占用的内存字节数, 约数
+	 *
+	 * @return size_t
+	 */
+	size_t memory() const;
+
+private:
+	struct Columns
+	{
+		std::vector<std::string> vNames;
+		std::unordered_map<std::string, size_t> mapIndex;
+	};
+
+	std::shared_ptr<const Columns> columns_; // 拷贝结果集时共享
+	std::vector<char> vArena_;				 // 全部单元格数据
+	std::vector<size_t> vOffsets_;			 // 第i个单元格为[vOffsets_[i], vOffsets_[i + 1])
+	std::vector<bool> vNulls_;				 // 按位存储
+};
+
 class SZ_DBResult
 {
 public:
@@ -66,6 +407,58 @@ private:
 	std::vector<std::map<std::string, std::string>> result_;
 };
 
+/**
+ * @brief 多语句批量执行中单条语句的结果
+ */
+struct SZ_DBStatementResult
+{
+	size_t index;			// 语句序号, 从0开始
+	bool hasResult;			// 是否返回结果集
+	SZ_DBTable table;		// 结果集
+	uint64_t affectedRows;	// 影响的行数, 查询语句为结果行数
+	uint64_t lastInsertId;	// 产生的自增ID
+	unsigned int warnings;	// 警告数
+
+	SZ_DBStatementResult() : index(0), hasResult(false), affectedRows(0), lastInsertId(0), warnings(0) {}
+};
+
+/**
+ * @brief 多语句批量执行中某条语句出错, 服务端不再执行其后的语句
+ */
+class SZ_Mysql_StatementException : public SZ_Mysql_Exception
+{
+public:
+	SZ_Mysql_StatementException(const std::string &sErr, size_t index, unsigned int errorCode, std::vector<SZ_DBStatementResult> &&vResults)
+		: SZ_Mysql_Exception(sErr), index_(index), errorCode_(errorCode), vResults_(std::move(vResults)) {}
+	virtual ~SZ_Mysql_StatementException() noexcept {}
+
+	/**
+	 * @brief 出错语句的序号
+	 *
+	 * @return size_t
+	 */
+	size_t index() const { return index_; }
+
+	/**
+	 * @brief 错误码, 即mysql_errno
+	 *
+	 * @return unsigned int
+	 */
+	unsigned int errorCode() const { return errorCode_; }
+
+	/**
+	 * @brief 出错之前已执行成功的语句的结果
+	 *
+	 * @return const std::vector<SZ_DBStatementResult>&
+	 */
+	const std::vector<SZ_DBStatementResult> &results() const { return vResults_; }
+
+private:
+	size_t index_;
+	unsigned int errorCode_;
+	std::vector<SZ_DBStatementResult> vResults_;
+};
+
 class SZ_Mysql : public SZ_Uncopy
 {
 public:
@@ -104,6 +497,34 @@ public:
 	 */
 	void disconnect();
 
+	/**
+	 * @brief 检测连接是否可用, 不自动重连
+	 *
+	 * @return bool
+	 */
+	bool ping();
+
+	/**
+	 * @brief 是否已连接
+	 *
+	 * @return bool
+	 */
+	bool isConnected() const;
+
+	/**
+	 * @brief 连接序号, 每次connect加一, 用于判断依附于旧连接的句柄是否失效
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t generation() const;
+
+	/**
+	 * @brief 连接配置
+	 *
+	 * @return const SZ_DBConfig&
+	 */
+	const SZ_DBConfig &config() const;
+
 	/**
 	 * @brief 获取连接句柄
 	 *
@@ -119,6 +540,32 @@ public:
 	 */
 	SZ_DBResult query(const std::string &sSql);
 
+	/**
+	 * @brief 流式查询, 逐行读取, 内存占用与结果行数无关
+	 *
+	 * @param sSql
+	 * @return SZ_DBCursor
+	 */
+	SZ_DBCursor queryCursor(const std::string &sSql);
+
+	/**
+	 * @brief 流式查询, 每读到一行调用一次回调
+	 *
+	 * @param sSql
+	 * @param callback 返回false时停止读取
+	 * @return uint64_t 回调的行数
+	 */
+	uint64_t queryEach(const std::string &sSql, const std::function<bool(const SZ_DBCursor &)> &callback);
+
+	/**
+	 * @brief 查询, 结果以列式存储返回
+	 *        逐行读取并直接写入结果集, 客户端不再另存一份完整结果
+	 *
+	 * @param sSql
+	 * @return SZ_DBTable
+	 */
+	SZ_DBTable queryTable(const std::string &sSql);
+
 	/**
 	 * @brief 执行
 	 *
@@ -150,6 +597,17 @@ public:
 	 */
 	size_t executeDelete(const std::string &sSql);
 
+	/**
+	 * @brief 多条语句合并为一次发送, 逐条取回结果, 只需一次网络往返
+	 *        未在clientFlag中设置CLIENT_MULTI_STATEMENTS时, 执行前后各以mysql_set_server_option开关一次, 多两次往返
+	 *        每个元素须是单条语句, 末尾的分号可有可无; 语句间不是事务, 需要原子性时自行加BEGIN/COMMIT
+	 *        出错时抛出SZ_Mysql_StatementException, 其中带有出错语句的序号和之前各语句的结果
+	 *
+	 * @param vSqls
+	 * @return std::vector<SZ_DBStatementResult> 与vSqls一一对应
+	 */
+	std::vector<SZ_DBStatementResult> executeMulti(const std::vector<std::string> &vSqls);
+
 	/**
 	 * @brief 获取受影响的行数
 	 *
@@ -172,10 +630,57 @@ public:
 	 */
 	std::string escapeString(const std::string &sFrom);
 
+	/**
+	 * @brief 取预处理语句, 按SQL文本缓存在本连接上, 超出缓存上限时淘汰最久未用的
+	 *        返回的语句不可在本连接析构后使用, 同一SQL返回同一对象, 不可嵌套使用
+	 *
+	 * @param sSql
+	 * @return std::shared_ptr<SZ_MysqlStmt>
+	 */
+	std::shared_ptr<SZ_MysqlStmt> prepare(const std::string &sSql);
+
+	/**
+	 * @brief 设置预处理语句缓存上限, 默认128
+	 *
+	 * @param size
+	 */
+	void setStmtCacheSize(size_t size);
+
+	/**
+	 * @brief 连接句柄上最近一次错误的描述, 含错误码、错误信息与SQLSTATE
+	 *
+	 * @param mysqlHandle
+	 * @return std::string
+	 */
+	static std::string mysqlError(MYSQL *mysqlHandle);
+
+	/**
+	 * @brief 错误码是否表示连接已断开(CR_SERVER_GONE_ERROR, CR_SERVER_LOST)
+	 *
+	 * @param iErrno
+	 * @return bool
+	 */
+	static bool isConnectionLost(unsigned int iErrno);
+
+protected:
+	/**
+	 * @brief 发送语句, 连接断开时重连一次, 失败时抛出SZ_Mysql_Exception
+	 *
+	 * @param sSql
+	 */
+	void realQuery(const std::string &sSql);
+
 private:
+	typedef std::list<std::shared_ptr<SZ_MysqlStmt>> StmtList;
+
 	SZ_DBConfig config_; // 配置项
 	bool isConnect_;	 // 是否连接
 	MYSQL *handle_;		 // 连接句柄
+	uint64_t generation_; // 连接序号
+
+	size_t stmtCacheSize_;										 // 预处理语句缓存上限
+	StmtList lstStmts_;											 // 最近使用的在前
+	std::unordered_map<std::string, StmtList::iterator> mapStmts_; // SQL文本 -> lstStmts_中的位置
 };
 
 #endif // SZ_USE_MYSQL
@@ -0,0 +1,460 @@
+#include "SZMysqlAsync.h"
+
+#if defined SZ_USE_MYSQL
+
+#if defined SZ_MYSQL_NONBLOCK
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+SZ_MysqlAsync::SZ_MysqlAsync(SZ_MysqlPool &pool, size_t threads, int64_t acquireTimeout) : pool_(pool), acquireTimeout_(acquireTimeout)
+{
+    threadPool_.start(std::max<size_t>(1, threads));
+}
+
+SZ_MysqlAsync::~SZ_MysqlAsync()
+{
+    threadPool_.wait();
+    threadPool_.stop();
+}
+
+std::future<SZ_DBResult> SZ_MysqlAsync::query(const std::string &sSql)
+{
+    return run([sSql](SZ_Mysql &mysql) { return mysql.query(sSql); });
+}
+
+std::future<SZ_DBTable> SZ_MysqlAsync::queryTable(const std::string &sSql)
+{
+    return run([sSql](SZ_Mysql &mysql) { return mysql.queryTable(sSql); });
+}
+
+std::future<size_t> SZ_MysqlAsync::execute(const std::string &sSql)
+{
+    return run([sSql](SZ_Mysql &mysql) -> size_t {
+        mysql.execute(sSql);
+        return mysql.affectedRows();
+    });
+}
+
+void SZ_MysqlAsync::query(const std::string &sSql, const std::function<void(SZ_DBResult &)> &onResult, const ErrorCallback &onError)
+{
+    SZ_MysqlPool *pool = &pool_;
+    int64_t timeout = acquireTimeout_;
+    threadPool_.insert([pool, timeout, sSql, onResult, onError]() {
+        SZ_DBResult dbResult;
+        try
+        {
+            SZ_MysqlPool::Connection conn = pool->acquire(timeout);
+            try
+            {
+                dbResult = conn->query(sSql);
+            }
+            catch (...)
+            {
+                conn.discard();
+                throw;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            if (onError)
+            {
+                onError(e.what());
+            }
+            return;
+        }
+
+        // 回调在归还连接之后执行
+        if (onResult)
+        {
+            onResult(dbResult);
+        }
+    });
+}
+
+void SZ_MysqlAsync::execute(const std::string &sSql, const std::function<void(size_t)> &onResult, const ErrorCallback &onError)
+{
+    SZ_MysqlPool *pool = &pool_;
+    int64_t timeout = acquireTimeout_;
+    threadPool_.insert([pool, timeout, sSql, onResult, onError]() {
+        size_t affected = 0;
+        try
+        {
+            SZ_MysqlPool::Connection conn = pool->acquire(timeout);
+            try
+            {
+                conn->execute(sSql);
+                affected = conn->affectedRows();
+            }
+            catch (...)
+            {
+                conn.discard();
+                throw;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            if (onError)
+            {
+                onError(e.what());
+            }
+            return;
+        }
+
+        if (onResult)
+        {
+            onResult(affected);
+        }
+    });
+}
+
+void SZ_MysqlAsync::wait(int64_t timeout)
+{
+    threadPool_.wait(timeout);
+}
+
+#if defined SZ_MYSQL_NONBLOCK
+
+SZ_MysqlMultiplexer::SZ_MysqlMultiplexer(const SZ_DBConfig &config, size_t connections) : config_(config), active_(0), stop_(false)
+{
+    vSlots_.resize(std::max<size_t>(1, connections));
+    for (auto &slot : vSlots_)
+    {
+        slot.mysql.reset(new SZ_Mysql());
+        slot.mysql->initialize(config_);
+        slot.stage = STAGE_IDLE;
+        slot.wait = 0;
+        slot.error = 0;
+        slot.result = nullptr;
+    }
+
+    if (pipe(wakeFds_) != 0)
+    {
+        throw SZ_Mysql_Exception("pipe: [" + SZ_Common::toString(errno) + "]");
+    }
+    fcntl(wakeFds_[0], F_SETFL, fcntl(wakeFds_[0], F_GETFL) | O_NONBLOCK);
+    fcntl(wakeFds_[1], F_SETFL, fcntl(wakeFds_[1], F_GETFL) | O_NONBLOCK);
+
+    thread_ = std::thread(&SZ_MysqlMultiplexer::run, this);
+}
+
+SZ_MysqlMultiplexer::~SZ_MysqlMultiplexer()
+{
+    std::deque<std::unique_ptr<Request>> queRequests;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        stop_ = true;
+        queRequests.swap(queRequests_);
+    }
+    char c = 0;
+    (void)!write(wakeFds_[1], &c, 1);
+
+    for (auto &request : queRequests)
+    {
+        std::exception_ptr e = std::make_exception_ptr(SZ_Mysql_Exception("Multiplexer is stopped"));
+        request->isQuery ? request->table.set_exception(e) : request->affected.set_exception(e);
+    }
+
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+
+    close(wakeFds_[0]);
+    close(wakeFds_[1]);
+}
+
+std::future<SZ_DBTable> SZ_MysqlMultiplexer::query(const std::string &sSql)
+{
+    std::unique_ptr<Request> request(new Request());
+    request->sql = sSql;
+    request->isQuery = true;
+    std::future<SZ_DBTable> future = request->table.get_future();
+    submit(std::move(request));
+
+    return future;
+}
+
+std::future<size_t> SZ_MysqlMultiplexer::execute(const std::string &sSql)
+{
+    std::unique_ptr<Request> request(new Request());
+    request->sql = sSql;
+    request->isQuery = false;
+    std::future<size_t> future = request->affected.get_future();
+    submit(std::move(request));
+
+    return future;
+}
+
+size_t SZ_MysqlMultiplexer::pending()
+{
+    std::lock_guard<std::mutex> locker(mtx_);
+    return queRequests_.size() + active_.load();
+}
+
+void SZ_MysqlMultiplexer::submit(std::unique_ptr<Request> request)
+{
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        if (stop_)
+        {
+            throw SZ_Mysql_Exception("Multiplexer is stopped");
+        }
+        queRequests_.push_back(std::move(request));
+    }
+
+    // 管道满时事件线程必然会醒来, 写失败可以忽略
+    char c = 0;
+    (void)!write(wakeFds_[1], &c, 1);
+}
+
+void SZ_MysqlMultiplexer::run()
+{
+    std::vector<struct pollfd> vPollFds;
+    std::vector<Slot *> vWaiting;
+
+    while (true)
+    {
+        // 把排队的语句分给空闲连接
+        {
+            std::unique_lock<std::mutex> locker(mtx_);
+            if (stop_ && 0 == active_.load())
+            {
+                break;
+            }
+
+            // 语句可能在begin中直接结束, 连接随即空闲, 继续分配
+            for (auto &slot : vSlots_)
+            {
+                while (STAGE_IDLE == slot.stage && !queRequests_.empty())
+                {
+                    std::unique_ptr<Request> request = std::move(queRequests_.front());
+                    queRequests_.pop_front();
+                    ++active_;
+                    locker.unlock();
+                    begin(slot, std::move(request));
+                    locker.lock();
+                }
+            }
+        }
+
+        vPollFds.clear();
+        vWaiting.clear();
+        struct pollfd wake = {wakeFds_[0], POLLIN, 0};
+        vPollFds.push_back(wake);
+
+        int timeout = -1;
+        auto now = std::chrono::steady_clock::now();
+        for (auto &slot : vSlots_)
+        {
+            if (STAGE_IDLE == slot.stage)
+            {
+                continue;
+            }
+
+            struct pollfd pfd = {static_cast<int>(mysql_get_socket(slot.mysql->handle())), 0, 0};
+            pfd.events |= (slot.wait & MYSQL_WAIT_READ) ? POLLIN : 0;
+            pfd.events |= (slot.wait & MYSQL_WAIT_WRITE) ? POLLOUT : 0;
+            pfd.events |= (slot.wait & MYSQL_WAIT_EXCEPT) ? POLLPRI : 0;
+            vPollFds.push_back(pfd);
+            vWaiting.push_back(&slot);
+
+            if (slot.wait & MYSQL_WAIT_TIMEOUT)
+            {
+                int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(slot.deadline - now).count();
+                ms = std::max<int64_t>(0, ms);
+                timeout = timeout < 0 ? static_cast<int>(ms) : std::min(timeout, static_cast<int>(ms));
+            }
+        }
+
+        if (poll(vPollFds.data(), vPollFds.size(), timeout) < 0 && errno != EINTR)
+        {
+            // poll出错时稍作等待, 避免空转
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (vPollFds[0].revents & POLLIN)
+        {
+            char buf[64];
+            while (read(wakeFds_[0], buf, sizeof(buf)) > 0)
+            {
+            }
+        }
+
+        now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < vWaiting.size(); ++i)
+        {
+            Slot &slot = *vWaiting[i];
+            short revents = vPollFds[i + 1].revents;
+
+            int ready = 0;
+            ready |= (revents & (POLLIN | POLLHUP | POLLERR)) ? MYSQL_WAIT_READ : 0;
+            ready |= (revents & (POLLOUT | POLLHUP | POLLERR)) ? MYSQL_WAIT_WRITE : 0;
+            ready |= (revents & POLLPRI) ? MYSQL_WAIT_EXCEPT : 0;
+            ready &= slot.wait;
+            if (0 == ready && (slot.wait & MYSQL_WAIT_TIMEOUT) && now >= slot.deadline)
+            {
+                ready = MYSQL_WAIT_TIMEOUT;
+            }
+            if (0 == ready)
+            {
+                continue;
+            }
+
+            int status = STAGE_QUERY == slot.stage ? mysql_real_query_cont(&slot.error, slot.mysql->handle(), ready)
+                                                   : mysql_store_result_cont(&slot.result, slot.mysql->handle(), ready);
+            advance(slot, status);
+        }
+    }
+}
+
+void SZ_MysqlMultiplexer::begin(Slot &slot, std::unique_ptr<Request> request)
+{
+    slot.request = std::move(request);
+    slot.stage = STAGE_QUERY;
+    slot.wait = 0;
+    slot.error = 0;
+    slot.result = nullptr;
+
+    if (!slot.mysql->isConnected())
+    {
+        try
+        {
+            slot.mysql->connect();
+        }
+        catch (const SZ_Mysql_Exception &e)
+        {
+            fail(slot, e.what());
+            return;
+        }
+
+        // 非阻塞接口须在连接上开启, 建立连接仍是阻塞的
+        if (mysql_options(slot.mysql->handle(), MYSQL_OPT_NONBLOCK, 0))
+        {
+            std::string sErr = "mysql_options MYSQL_OPT_NONBLOCK: [" + SZ_Mysql::mysqlError(slot.mysql->handle()) + "]";
+            slot.mysql->disconnect();
+            fail(slot, sErr);
+            return;
+        }
+    }
+
+    const std::string &sSql = slot.request->sql;
+    advance(slot, mysql_real_query_start(&slot.error, slot.mysql->handle(), sSql.c_str(), sSql.length()));
+}
+
+void SZ_MysqlMultiplexer::advance(Slot &slot, int status)
+{
+    MYSQL *handle = slot.mysql->handle();
+    while (true)
+    {
+        if (0 != status)
+        {
+            slot.wait = status;
+            if (status & MYSQL_WAIT_TIMEOUT)
+            {
+                slot.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(mysql_get_timeout_value_ms(handle));
+            }
+            return;
+        }
+
+        if (STAGE_QUERY == slot.stage)
+        {
+            if (0 != slot.error)
+            {
+                fail(slot, "mysql_real_query: [ " + slot.request->sql + " ] [" + SZ_Mysql::mysqlError(handle) + "]");
+                return;
+            }
+
+            // 没有结果集的语句不会产生网络操作; 有结果集时即使是execute也须读完, 否则连接无法继续使用
+            slot.stage = STAGE_STORE;
+            status = mysql_store_result_start(&slot.result, handle);
+            continue;
+        }
+
+        // STAGE_STORE, 结果已全部读到客户端, 逐行读取不再有网络操作
+        MYSQL_RES *result = slot.result;
+        slot.result = nullptr;
+        if (!slot.request->isQuery)
+        {
+            if (nullptr != result)
+            {
+                mysql_free_result(result);
+            }
+            else if (0 != mysql_errno(handle))
+            {
+                fail(slot, "mysql_store_result: [" + slot.request->sql + "] [" + SZ_Mysql::mysqlError(handle) + "]");
+                return;
+            }
+            slot.request->affected.set_value(mysql_affected_rows(handle));
+            finish(slot);
+            return;
+        }
+
+        if (nullptr == result)
+        {
+            if (0 != mysql_errno(handle) || 0 != mysql_field_count(handle))
+            {
+                fail(slot, "mysql_store_result: [" + slot.request->sql + "] [" + SZ_Mysql::mysqlError(handle) + "]");
+                return;
+            }
+            slot.request->table.set_value(SZ_DBTable());
+            finish(slot);
+            return;
+        }
+
+        SZ_DBTable table;
+        std::vector<std::string> vFields;
+        MYSQL_FIELD *field;
+        while ((field = mysql_fetch_field(result)))
+        {
+            vFields.emplace_back(field->name);
+        }
+        table.setFields(vFields);
+        table.reserve(static_cast<size_t>(mysql_num_rows(result)));
+
+        std::vector<SZ_DBCell> vCells(vFields.size());
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result)) != nullptr)
+        {
+            unsigned long *lengths = mysql_fetch_lengths(result);
+            for (size_t i = 0; i < vCells.size(); ++i)
+            {
+                vCells[i] = SZ_DBCell(row[i], lengths[i]);
+            }
+            table.appendRow(vCells.data());
+        }
+        mysql_free_result(result);
+
+        slot.request->table.set_value(std::move(table));
+        finish(slot);
+        return;
+    }
+}
+
+void SZ_MysqlMultiplexer::fail(Slot &slot, const std::string &sErr)
+{
+    // 连接断开后下次使用时重连
+    unsigned int iErrno = slot.mysql->isConnected() ? mysql_errno(slot.mysql->handle()) : 0;
+    if (SZ_Mysql::isConnectionLost(iErrno))
+    {
+        slot.mysql->disconnect();
+    }
+
+    std::exception_ptr e = std::make_exception_ptr(SZ_Mysql_Exception(sErr));
+    slot.request->isQuery ? slot.request->table.set_exception(e) : slot.request->affected.set_exception(e);
+    finish(slot);
+}
+
+void SZ_MysqlMultiplexer::finish(Slot &slot)
+{
+    slot.request.reset();
+    slot.stage = STAGE_IDLE;
+    slot.wait = 0;
+    --active_;
+}
+
+#endif // SZ_MYSQL_NONBLOCK
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,256 @@
+#pragma once
+
+#if defined SZ_USE_MYSQL
+
+#include "SZMysqlPool.h"
+#include "SZThreadPool.h"
+
+#include <future>
+
+// MariaDB客户端库提供非阻塞接口(mysql_real_query_start/cont等), 以MYSQL_WAIT_READ是否定义判断
+#if defined SZ_TARGET_PLATFORM_LINUX && defined MYSQL_WAIT_READ
+#define SZ_MYSQL_NONBLOCK 1
+#endif
+
+/**
+ * @brief 异步执行, 语句在专用线程池上执行, 连接从连接池借用, 执行完即归还
+ *        结果以std::future返回, 或在工作线程上回调
+ *        执行中抛出异常时关闭所用连接, 不放回连接池: 连接上可能留有未结束的事务或会话状态, ping检测不出
+ *        析构时等待已提交的语句执行完毕
+ *
+ *        SZ_MysqlAsync async(pool, 4);
+ *        std::future<SZ_DBResult> users = async.query("SELECT * FROM user");
+ *        std::future<SZ_DBResult> orders = async.query("SELECT * FROM orders");
+ *        users.get(); orders.get();
+ */
+class SZ_MysqlAsync : public SZ_Uncopy
+{
+public:
+	typedef std::function<void(const std::string &sErr)> ErrorCallback;
+
+public:
+	/**
+	 * @brief 构造并启动线程池
+	 *
+	 * @param pool 须比本对象存活更久
+	 * @param threads 线程数, 超过连接池上限的线程只会等待连接
+	 * @param acquireTimeout 借用连接的超时毫秒数, -1为一直等待
+	 */
+	SZ_MysqlAsync(SZ_MysqlPool &pool, size_t threads = 4, int64_t acquireTimeout = -1);
+
+	~SZ_MysqlAsync();
+
+	/**
+	 * @brief 查询
+	 *
+	 * @param sSql
+	 * @return std::future<SZ_DBResult> 失败时get抛出SZ_Mysql_Exception
+	 */
+	std::future<SZ_DBResult> query(const std::string &sSql);
+
+	/**
+	 * @brief 查询, 结果以列式存储返回
+	 *
+	 * @param sSql
+	 * @return std::future<SZ_DBTable>
+	 */
+	std::future<SZ_DBTable> queryTable(const std::string &sSql);
+
+	/**
+	 * @brief 执行
+	 *
+	 * @param sSql
+	 * @return std::future<size_t> 影响的行数
+	 */
+	std::future<size_t> execute(const std::string &sSql);
+
+	/**
+	 * @brief 查询, 完成后在工作线程上回调
+	 *
+	 * @param sSql
+	 * @param onResult
+	 * @param onError 为空时忽略错误
+	 */
+	void query(const std::string &sSql, const std::function<void(SZ_DBResult &)> &onResult, const ErrorCallback &onError = nullptr);
+
+	/**
+	 * @brief 执行, 完成后在工作线程上回调
+	 *
+	 * @param sSql
+	 * @param onResult 参数为影响的行数
+	 * @param onError 为空时忽略错误
+	 */
+	void execute(const std::string &sSql, const std::function<void(size_t)> &onResult, const ErrorCallback &onError = nullptr);
+
+	/**
+	 * @brief 以借用的连接执行任意操作, 如事务或预处理语句
+	 *        func抛出异常时连接被关闭, 未提交的事务随之回滚
+	 *
+	 * @tparam Func 形如 R(SZ_Mysql &)
+	 * @param func
+	 * @return std::future<R>
+	 */
+	template <typename Func>
+	auto run(Func func) -> std::future<decltype(func(std::declval<SZ_Mysql &>()))>
+	{
+		typedef decltype(func(std::declval<SZ_Mysql &>())) Result;
+
+		SZ_MysqlPool *pool = &pool_;
+		int64_t timeout = acquireTimeout_;
+		return threadPool_.insert([pool, timeout, func]() mutable -> Result {
+			SZ_MysqlPool::Connection conn = pool->acquire(timeout);
+			try
+			{
+				return func(*conn);
+			}
+			catch (...)
+			{
+				conn.discard();
+				throw;
+			}
+		});
+	}
+
+	/**
+	 * @brief 等待已提交的语句执行完毕
+	 *
+	 * @param timeout 毫秒, -1为一直等待
+	 */
+	void wait(int64_t timeout = -1);
+
+private:
+	SZ_MysqlPool &pool_;
+	int64_t acquireTimeout_;
+	SZ_ThreadPool threadPool_;
+};
+
+#if defined SZ_MYSQL_NONBLOCK
+
+/**
+ * @brief 基于MariaDB非阻塞接口的多路复用执行, 一个线程以poll同时驱动多个连接
+ *        语句按提交顺序分配给空闲连接, 连接不够时排队
+ *        连接在首次使用时建立, 建立连接本身是阻塞的; 连接断开的语句直接失败不重试, 下次使用时重连
+ *        析构时排队中的语句以异常结束, 正在执行的语句等待完成
+ */
+class SZ_MysqlMultiplexer : public SZ_Uncopy
+{
+public:
+	/**
+	 * @brief 构造并启动事件线程
+	 *
+	 * @param config
+	 * @param connections 连接数, 即同时执行的语句数
+	 */
+	SZ_MysqlMultiplexer(const SZ_DBConfig &config, size_t connections = 8);
+
+	~SZ_MysqlMultiplexer();
+
+	/**
+	 * @brief 查询
+	 *
+	 * @param sSql
+	 * @return std::future<SZ_DBTable> 失败时get抛出SZ_Mysql_Exception
+	 */
+	std::future<SZ_DBTable> query(const std::string &sSql);
+
+	/**
+	 * @brief 执行
+	 *
+	 * @param sSql
+	 * @return std::future<size_t> 影响的行数
+	 */
+	std::future<size_t> execute(const std::string &sSql);
+
+	/**
+	 * @brief 排队和执行中的语句数
+	 *
+	 * @return size_t
+	 */
+	size_t pending();
+
+protected:
+	struct Request
+	{
+		std::string sql;
+		bool isQuery;
+		std::promise<SZ_DBTable> table;
+		std::promise<size_t> affected;
+	};
+
+	enum Stage
+	{
+		STAGE_IDLE,
+		STAGE_QUERY,
+		STAGE_STORE,
+	};
+
+	struct Slot
+	{
+		std::unique_ptr<SZ_Mysql> mysql;
+		std::unique_ptr<Request> request;
+		Stage stage;
+		int wait;	   // 等待的事件, MYSQL_WAIT_*
+		int error;	   // mysql_real_query的返回值
+		MYSQL_RES *result;
+		std::chrono::steady_clock::time_point deadline; // 等待MYSQL_WAIT_TIMEOUT时的截止时间
+	};
+
+	/**
+	 * @brief 提交到队列并唤醒事件线程
+	 *
+	 * @param request
+	 */
+	void submit(std::unique_ptr<Request> request);
+
+	/**
+	 * @brief 事件循环
+	 */
+	void run();
+
+	/**
+	 * @brief 在空闲连接上开始执行
+	 *
+	 * @param slot
+	 * @param request
+	 */
+	void begin(Slot &slot, std::unique_ptr<Request> request);
+
+	/**
+	 * @brief 按非阻塞调用的返回值推进, 需要等待时记下等待的事件后返回
+	 *
+	 * @param slot
+	 * @param status
+	 */
+	void advance(Slot &slot, int status);
+
+	/**
+	 * @brief 以失败结束当前语句
+	 *
+	 * @param slot
+	 * @param sErr
+	 */
+	void fail(Slot &slot, const std::string &sErr);
+
+	/**
+	 * @brief 结束当前语句, 连接回到空闲
+	 *
+	 * @param slot
+	 */
+	void finish(Slot &slot);
+
+private:
+	SZ_DBConfig config_;
+	std::vector<Slot> vSlots_;
+
+	std::mutex mtx_;
+	std::deque<std::unique_ptr<Request>> queRequests_;
+	std::atomic_size_t active_; // 执行中的语句数
+	bool stop_;
+
+	int wakeFds_[2]; // 唤醒poll的管道
+	std::thread thread_;
+};
+
+#endif // SZ_MYSQL_NONBLOCK
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,261 @@
+#include "SZMysqlBatch.h"
+
+#if defined SZ_USE_MYSQL
+
+#include <cmath>
+#include <cstdio>
+
+SZ_MysqlBatchInsert::SZ_MysqlBatchInsert(SZ_Mysql *mysql, const std::string &sTable, const std::vector<std::string> &vColumns)
+    : mysql_(mysql), table_(sTable), vColumns_(vColumns), ignore_(false), maxPacket_(0), maxRows_(0), prepared_(false), limit_(0), pending_(0),
+      rows_(0), affectedRows_(0)
+{
+    if (vColumns_.empty())
+    {
+        throw SZ_Mysql_Exception("Batch insert into " + table_ + " has no columns");
+    }
+}
+
+SZ_MysqlBatchInsert::~SZ_MysqlBatchInsert()
+{
+}
+
+void SZ_MysqlBatchInsert::setIgnore(bool ignore)
+{
+    ignore_ = ignore;
+    prepared_ = false;
+}
+
+void SZ_MysqlBatchInsert::setOnDuplicateUpdate(const std::vector<std::string> &vColumns)
+{
+    std::string sClause;
+    for (size_t i = 0; i < vColumns.size(); ++i)
+    {
+        if (i > 0)
+        {
+            sClause += ",";
+        }
+        sClause += vColumns[i] + "=VALUES(" + vColumns[i] + ")";
+    }
+    setOnDuplicateUpdate(sClause);
+}
+
+void SZ_MysqlBatchInsert::setOnDuplicateUpdate(const std::string &sClause)
+{
+    update_ = sClause;
+    prepared_ = false;
+}
+
+void SZ_MysqlBatchInsert::setMaxPacket(size_t bytes)
+{
+    maxPacket_ = bytes;
+    prepared_ = false;
+}
+
+void SZ_MysqlBatchInsert::setMaxRows(size_t rows)
+{
+    maxRows_ = rows;
+}
+
+SZ_MysqlBatchInsert &SZ_MysqlBatchInsert::add(const std::vector<SZ_DBValue> &vRow)
+{
+    if (vRow.size() != vColumns_.size())
+    {
+        throw SZ_Mysql_Exception("Batch insert into " + table_ + " expects " + SZ_Common::toString(vColumns_.size()) + " values, got " +
+                                 SZ_Common::toString(vRow.size()));
+    }
+
+    if (!prepared_ && pending_ == 0)
+    {
+        prepare();
+    }
+
+    format(vRow);
+
+    // 放不进当前批时先发送当前批
+    if (pending_ > 0 && ((maxRows_ > 0 && pending_ >= maxRows_) || sql_.size() + 1 + tuple_.size() + suffix_.size() > limit_))
+    {
+        flush();
+    }
+
+    if (pending_ == 0)
+    {
+        if (prefix_.size() + tuple_.size() + suffix_.size() > limit_)
+        {
+            throw SZ_Mysql_Exception("Batch insert into " + table_ + " row of " + SZ_Common::toString(tuple_.size()) + " bytes exceeds packet limit " +
+                                     SZ_Common::toString(limit_));
+        }
+        sql_ = prefix_;
+    }
+    else
+    {
+        sql_ += ',';
+    }
+    sql_ += tuple_;
+    ++pending_;
+    ++rows_;
+
+    return *this;
+}
+
+uint64_t SZ_MysqlBatchInsert::flush()
+{
+    if (pending_ == 0)
+    {
+        return 0;
+    }
+
+    sql_ += suffix_;
+    pending_ = 0;
+
+    uint64_t affected = 0;
+    try
+    {
+        affected = mysql_->executeInsert(sql_);
+    }
+    catch (...)
+    {
+        sql_.clear();
+        throw;
+    }
+    sql_.clear();
+
+    affectedRows_ += affected;
+    vBatchAffected_.push_back(affected);
+
+    return affected;
+}
+
+uint64_t SZ_MysqlBatchInsert::rows() const
+{
+    return rows_;
+}
+
+size_t SZ_MysqlBatchInsert::pending() const
+{
+    return pending_;
+}
+
+uint64_t SZ_MysqlBatchInsert::affectedRows() const
+{
+    return affectedRows_;
+}
+
+const std::vector<uint64_t> &SZ_MysqlBatchInsert::batchAffectedRows() const
+{
+    return vBatchAffected_;
+}
+
+void SZ_MysqlBatchInsert::prepare()
+{
+    prefix_ = ignore_ ? "INSERT IGNORE INTO " : "INSERT INTO ";
+    prefix_ += table_ + " (";
+    for (size_t i = 0; i < vColumns_.size(); ++i)
+    {
+        if (i > 0)
+        {
+            prefix_ += ",";
+        }
+        prefix_ += vColumns_[i];
+    }
+    prefix_ += ") VALUES ";
+
+    suffix_.clear();
+    if (!update_.empty())
+    {
+        suffix_ = " ON DUPLICATE KEY UPDATE " + update_;
+    }
+
+    size_t maxPacket = maxPacket_;
+    if (maxPacket == 0)
+    {
+        SZ_DBCursor cursor = mysql_->queryCursor("SELECT @@max_allowed_packet");
+        if (cursor.next() && !cursor[0].isNull())
+        {
+            maxPacket = static_cast<size_t>(strtoull(cursor[0].str().c_str(), nullptr, 10));
+        }
+        if (maxPacket == 0)
+        {
+            throw SZ_Mysql_Exception("Can not get max_allowed_packet");
+        }
+    }
+
+    // 留出包头和命令字节
+    limit_ = maxPacket - std::min<size_t>(1024, maxPacket / 16);
+    prepared_ = true;
+}
+
+void SZ_MysqlBatchInsert::format(const std::vector<SZ_DBValue> &vRow)
+{
+    tuple_.clear();
+    tuple_ += '(';
+    for (size_t i = 0; i < vRow.size(); ++i)
+    {
+        if (i > 0)
+        {
+            tuple_ += ',';
+        }
+        appendValue(vRow[i]);
+    }
+    tuple_ += ')';
+}
+
+void SZ_MysqlBatchInsert::appendValue(const SZ_DBValue &value)
+{
+    char buf[32];
+    int len = 0;
+    switch (value.type())
+    {
+    case SZ_DBValue::TYPE_NULL:
+        tuple_ += "NULL";
+        break;
+    case SZ_DBValue::TYPE_INT:
+        len = snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value.toInt()));
+        tuple_.append(buf, len);
+        break;
+    case SZ_DBValue::TYPE_UINT:
+        len = snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value.toUInt()));
+        tuple_.append(buf, len);
+        break;
+    case SZ_DBValue::TYPE_DOUBLE:
+        if (!std::isfinite(value.toDouble()))
+        {
+            throw SZ_Mysql_Exception("Batch insert into " + table_ + " can not store non-finite double");
+        }
+        len = snprintf(buf, sizeof(buf), "%.17g", value.toDouble());
+        tuple_.append(buf, len);
+        break;
+    case SZ_DBValue::TYPE_STRING:
+    {
+        // 转义后最长为原长的2倍, 按连接字符集转义, 须先连接
+        if (!mysql_->isConnected())
+        {
+            mysql_->connect();
+        }
+        size_t pos = tuple_.size();
+        tuple_.resize(pos + value.size() * 2 + 3);
+        tuple_[pos] = '\'';
+        unsigned long n = mysql_real_escape_string(mysql_->handle(), &tuple_[pos + 1], static_cast<const char *>(value.data()), value.size());
+        if (n == static_cast<unsigned long>(-1))
+        {
+            // 会话开启NO_BACKSLASH_ESCAPES时无法以反斜杠转义
+            throw SZ_Mysql_Exception("mysql_real_escape_string: [" + table_ + "] [" + SZ_Mysql::mysqlError(mysql_->handle()) + "]");
+        }
+        tuple_[pos + 1 + n] = '\'';
+        tuple_.resize(pos + n + 2);
+        break;
+    }
+    case SZ_DBValue::TYPE_BLOB:
+    {
+        size_t pos = tuple_.size();
+        tuple_.resize(pos + value.size() * 2 + 4);
+        tuple_[pos] = 'X';
+        tuple_[pos + 1] = '\'';
+        unsigned long n = mysql_hex_string(&tuple_[pos + 2], static_cast<const char *>(value.data()), value.size());
+        tuple_[pos + 2 + n] = '\'';
+        tuple_.resize(pos + n + 3);
+        break;
+    }
+    }
+}
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,158 @@
+#pragma once
+
+#if defined SZ_USE_MYSQL
+
+#include "SZMysql.h"
+
+/**
+ * @brief 批量插入, 多行合并为一条INSERT ... VALUES (...),(...)
+ *        语句长度接近max_allowed_packet或行数达到上限时自动发送一批
+ *        字符串按连接字符集转义, 二进制以X'...'写入
+ *        析构时不会自动发送剩余的行, 须显式调用flush
+ *
+ *        SZ_MysqlBatchInsert batch(&mysql, "user", {"id", "name", "score"});
+ *        batch.setOnDuplicateUpdate(std::vector<std::string>{"name", "score"});
+ *        for (...)
+ *        {
+ *            batch.add({id, name, score});
+ *        }
+ *        batch.flush();
+ */
+class SZ_MysqlBatchInsert : public SZ_Uncopy
+{
+public:
+	/**
+	 * @brief 构造
+	 *
+	 * @param mysql 须比本对象存活更久
+	 * @param sTable 表名, 原样写入SQL
+	 * @param vColumns 列名, 原样写入SQL
+	 */
+	SZ_MysqlBatchInsert(SZ_Mysql *mysql, const std::string &sTable, const std::vector<std::string> &vColumns);
+
+	~SZ_MysqlBatchInsert();
+
+	/**
+	 * @brief 使用INSERT IGNORE, 须在add之前设置
+	 *
+	 * @param ignore
+	 */
+	void setIgnore(bool ignore);
+
+	/**
+	 * @brief 主键或唯一键冲突时以新值更新这些列, 即col=VALUES(col), 须在add之前设置
+	 *
+	 * @param vColumns
+	 */
+	void setOnDuplicateUpdate(const std::vector<std::string> &vColumns);
+
+	/**
+	 * @brief 主键或唯一键冲突时执行的更新, 原样写在ON DUPLICATE KEY UPDATE之后, 须在add之前设置
+	 *
+	 * @param sClause 如 "cnt=cnt+VALUES(cnt)"
+	 */
+	void setOnDuplicateUpdate(const std::string &sClause);
+
+	/**
+	 * @brief 单条语句的字节上限, 为0时取服务端的max_allowed_packet
+	 *
+	 * @param bytes
+	 */
+	void setMaxPacket(size_t bytes);
+
+	/**
+	 * @brief 单条语句的行数上限, 为0时只按字节数切分, 用于控制单批持锁时间
+	 *
+	 * @param rows
+	 */
+	void setMaxRows(size_t rows);
+
+	/**
+	 * @brief 添加一行, 放不进当前批时先发送当前批
+	 *        单行超过字节上限或列数不符时抛出SZ_Mysql_Exception
+	 *
+	 * @param vRow 顺序与构造时的列名一致
+	 * @return SZ_MysqlBatchInsert&
+	 */
+	SZ_MysqlBatchInsert &add(const std::vector<SZ_DBValue> &vRow);
+
+	/**
+	 * @brief 发送未发送的行, 失败时抛出SZ_Mysql_Exception, 本批的行被丢弃
+	 *
+	 * @return uint64_t 本批影响的行数, 没有未发送的行时为0
+	 */
+	uint64_t flush();
+
+	/**
+	 * @brief 已添加的行数
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t rows() const;
+
+	/**
+	 * @brief 尚未发送的行数
+	 *
+	 * @return size_t
+	 */
+	size_t pending() const;
+
+	/**
+	 * @brief 累计影响的行数
+	 *        ON DUPLICATE KEY UPDATE时插入计1, 更新计2, 值不变计0
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t affectedRows() const;
+
+	/**
+	 * @brief 每批影响的行数, 按发送顺序
+	 *
+	 * @return const std::vector<uint64_t>&
+	 */
+	const std::vector<uint64_t> &batchAffectedRows() const;
+
+protected:
+	/**
+	 * @brief 生成语句头尾, 取得字节上限
+	 */
+	void prepare();
+
+	/**
+	 * @brief 把一行格式化为 (v1,v2,...) 写入tuple_
+	 *
+	 * @param vRow
+	 */
+	void format(const std::vector<SZ_DBValue> &vRow);
+
+	/**
+	 * @brief 追加一个值
+	 *
+	 * @param value
+	 */
+	void appendValue(const SZ_DBValue &value);
+
+private:
+	SZ_Mysql *mysql_;
+	std::string table_;
+	std::vector<std::string> vColumns_;
+	bool ignore_;
+	std::string update_; // ON DUPLICATE KEY UPDATE之后的部分
+	size_t maxPacket_;
+	size_t maxRows_;
+
+	bool prepared_;
+	std::string prefix_; // INSERT ... VALUES
+	std::string suffix_; // ON DUPLICATE KEY UPDATE ...
+	size_t limit_;		 // 单条语句的字节上限
+
+	std::string sql_;	// 当前批
+	std::string tuple_; // 当前行, 复用缓冲
+	size_t pending_;
+
+	uint64_t rows_;
+	uint64_t affectedRows_;
+	std::vector<uint64_t> vBatchAffected_;
+};
+
+#endif // SZ_USE_MYSQL
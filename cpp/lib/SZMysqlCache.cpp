@@ -0,0 +1,328 @@
+#include "SZMysqlCache.h"
+#include "SZMysqlStmt.h"
+
+#if defined SZ_USE_MYSQL
+
+SZ_MysqlCache::SZ_MysqlCache(size_t maxBytes, int64_t defaultTtl) : maxBytes_(maxBytes), defaultTtl_(defaultTtl)
+{
+}
+
+SZ_MysqlCache::~SZ_MysqlCache()
+{
+}
+
+SZ_MysqlCache::TablePtr SZ_MysqlCache::query(SZ_Mysql &mysql, const std::string &sSql, const std::vector<std::string> &vTags, int64_t ttl)
+{
+    return get(makeKey(sSql, std::vector<SZ_DBValue>(), false), [&mysql, &sSql]() { return mysql.queryTable(sSql); }, vTags, ttl);
+}
+
+SZ_MysqlCache::TablePtr SZ_MysqlCache::queryPrepared(SZ_Mysql &mysql, const std::string &sSql, const std::vector<SZ_DBValue> &vParams,
+                                                     const std::vector<std::string> &vTags, int64_t ttl)
+{
+    return get(
+        makeKey(sSql, vParams, true),
+        [&mysql, &sSql, &vParams]() {
+            std::shared_ptr<SZ_MysqlStmt> stmt = mysql.prepare(sSql);
+            stmt->execute(vParams);
+
+            SZ_DBTable table;
+            table.setFields(stmt->fields());
+
+            std::vector<std::string> vValues(stmt->fields().size());
+            std::vector<SZ_DBCell> vCells(vValues.size());
+            while (stmt->fetch())
+            {
+                for (size_t i = 0; i < vCells.size(); ++i)
+                {
+                    if (stmt->isNull(i))
+                    {
+                        vCells[i] = SZ_DBCell();
+                    }
+                    else
+                    {
+                        vValues[i] = stmt->getString(i);
+                        vCells[i] = SZ_DBCell(vValues[i].data(), vValues[i].size());
+                    }
+                }
+                table.appendRow(vCells.data());
+            }
+            stmt->freeResult();
+
+            return table;
+        },
+        vTags, ttl);
+}
+
+SZ_MysqlCache::TablePtr SZ_MysqlCache::get(const std::string &key, const Loader &loader, const std::vector<std::string> &vTags, int64_t ttl)
+{
+    std::promise<TablePtr> promise;
+    std::shared_ptr<Loading> loading;
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        auto it = mapEntries_.find(key);
+        if (it != mapEntries_.end())
+        {
+            if (!it->second->expires || Clock::now() < it->second->expireAt)
+            {
+                lstEntries_.splice(lstEntries_.begin(), lstEntries_, it->second);
+                ++stats_.hits;
+                return lstEntries_.front().table;
+            }
+
+            erase(it->second);
+            ++stats_.expirations;
+        }
+
+        ++stats_.misses;
+
+        // 已有线程在加载同一键, 等待其结果; 失效过的加载已从mapLoading_移除, 不会等到旧结果
+        auto inflight = mapLoading_.find(key);
+        if (inflight != mapLoading_.end())
+        {
+            std::shared_future<TablePtr> future = inflight->second->future;
+            ++stats_.coalesced;
+            locker.unlock();
+            return future.get();
+        }
+
+        loading = std::make_shared<Loading>();
+        loading->future = promise.get_future().share();
+        loading->vTags = vTags;
+        loading->stale = false;
+        mapLoading_[key] = loading;
+        ++stats_.loads;
+    }
+
+    TablePtr table;
+    try
+    {
+        table = std::make_shared<const SZ_DBTable>(loader());
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            finishLoading(key, loading);
+            ++stats_.loadFailures;
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        finishLoading(key, loading);
+        if (!loading->stale)
+        {
+            insert(key, table, vTags, ttl);
+        }
+    }
+    promise.set_value(table);
+
+    return table;
+}
+
+size_t SZ_MysqlCache::invalidate(const std::string &tag)
+{
+    std::lock_guard<std::mutex> locker(mtx_);
+
+    // 带此标签的加载结果作废, 之后的请求重新加载
+    for (auto loading = mapLoading_.begin(); loading != mapLoading_.end();)
+    {
+        const std::vector<std::string> &vTags = loading->second->vTags;
+        if (std::find(vTags.begin(), vTags.end(), tag) != vTags.end())
+        {
+            loading->second->stale = true;
+            loading = mapLoading_.erase(loading);
+        }
+        else
+        {
+            ++loading;
+        }
+    }
+
+    auto it = mapTags_.find(tag);
+    if (it == mapTags_.end())
+    {
+        return 0;
+    }
+
+    // erase会修改标签集合, 先取出键
+    std::vector<std::string> vKeys(it->second.begin(), it->second.end());
+    for (auto &key : vKeys)
+    {
+        auto entry = mapEntries_.find(key);
+        if (entry != mapEntries_.end())
+        {
+            erase(entry->second);
+        }
+    }
+    stats_.invalidations += vKeys.size();
+
+    return vKeys.size();
+}
+
+void SZ_MysqlCache::clear()
+{
+    std::lock_guard<std::mutex> locker(mtx_);
+    for (auto &loading : mapLoading_)
+    {
+        loading.second->stale = true;
+    }
+    mapLoading_.clear();
+    lstEntries_.clear();
+    mapEntries_.clear();
+    mapTags_.clear();
+    stats_.bytes = 0;
+}
+
+SZ_MysqlCacheStats SZ_MysqlCache::stats()
+{
+    std::lock_guard<std::mutex> locker(mtx_);
+    SZ_MysqlCacheStats stats = stats_;
+    stats.entries = mapEntries_.size();
+
+    return stats;
+}
+
+std::string SZ_MysqlCache::makeKey(const std::string &sSql, const std::vector<SZ_DBValue> &vParams, bool prepared)
+{
+    // 文本协议与预处理语句取回的结果格式不尽相同, 不共用条目
+    std::string key(1, prepared ? 'P' : 'T');
+    key += normalize(sSql);
+    for (auto &param : vParams)
+    {
+        // 类型与长度前缀, 保证不同的参数序列不会拼出相同的键
+        key += '\0';
+        key += static_cast<char>('0' + param.type());
+        key += SZ_Common::toString(param.size());
+        key += ':';
+        key.append(static_cast<const char *>(param.data()), param.size());
+    }
+
+    return key;
+}
+
+std::string SZ_MysqlCache::normalize(const std::string &sSql)
+{
+    std::string str;
+    str.reserve(sSql.size());
+
+    char quote = 0;
+    bool space = false;
+    for (size_t i = 0; i < sSql.size(); ++i)
+    {
+        char c = sSql[i];
+        if (quote)
+        {
+            str += c;
+            if (c == '\\' && quote != '`' && i + 1 < sSql.size())
+            {
+                str += sSql[++i];
+            }
+            else if (c == quote)
+            {
+                quote = 0;
+            }
+            continue;
+        }
+
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v')
+        {
+            space = true;
+            continue;
+        }
+
+        if (space && !str.empty())
+        {
+            str += ' ';
+        }
+        space = false;
+
+        if (c == '\'' || c == '"' || c == '`')
+        {
+            quote = c;
+        }
+        str += c;
+    }
+
+    return str;
+}
+
+void SZ_MysqlCache::finishLoading(const std::string &key, const std::shared_ptr<Loading> &loading)
+{
+    // 已失效的加载可能已被同一键的新加载取代, 只移除自己
+    auto it = mapLoading_.find(key);
+    if (it != mapLoading_.end() && it->second == loading)
+    {
+        mapLoading_.erase(it);
+    }
+}
+
+void SZ_MysqlCache::erase(EntryList::iterator it)
+{
+    for (auto &tag : it->vTags)
+    {
+        auto keys = mapTags_.find(tag);
+        if (keys != mapTags_.end())
+        {
+            keys->second.erase(it->key);
+            if (keys->second.empty())
+            {
+                mapTags_.erase(keys);
+            }
+        }
+    }
+
+    stats_.bytes -= it->bytes;
+    mapEntries_.erase(it->key);
+    lstEntries_.erase(it);
+}
+
+void SZ_MysqlCache::insert(const std::string &key, const TablePtr &table, const std::vector<std::string> &vTags, int64_t ttl)
+{
+    if (0 == ttl)
+    {
+        ttl = defaultTtl_;
+    }
+
+    // 键在mapEntries_, 标签集合与条目中各存一份
+    size_t bytes = sizeof(Entry) + table->memory() + key.size() * (2 + vTags.size());
+    for (auto &tag : vTags)
+    {
+        bytes += tag.size();
+    }
+    if (bytes > maxBytes_)
+    {
+        return;
+    }
+
+    auto it = mapEntries_.find(key);
+    if (it != mapEntries_.end())
+    {
+        erase(it->second);
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.table = table;
+    entry.vTags = vTags;
+    entry.expires = ttl > 0;
+    entry.expireAt = Clock::now() + std::chrono::milliseconds(std::max<int64_t>(0, ttl));
+    entry.bytes = bytes;
+    lstEntries_.push_front(std::move(entry));
+    mapEntries_[key] = lstEntries_.begin();
+    for (auto &tag : vTags)
+    {
+        mapTags_[tag].insert(key);
+    }
+    stats_.bytes += bytes;
+
+    while (stats_.bytes > maxBytes_ && !lstEntries_.empty())
+    {
+        erase(std::prev(lstEntries_.end()));
+        ++stats_.evictions;
+    }
+}
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,196 @@
+#pragma once
+
+#if defined SZ_USE_MYSQL
+
+#include "SZMysql.h"
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_set>
+
+/**
+ * @brief 结果缓存统计
+ */
+struct SZ_MysqlCacheStats
+{
+	size_t entries;			// 条目数
+	size_t bytes;			// 条目占用的内存
+	uint64_t hits;			// 命中次数
+	uint64_t misses;		// 未命中次数, 含等待其他线程加载的
+	uint64_t coalesced;		// 未命中时等待其他线程加载的次数
+	uint64_t loads;			// 加载次数
+	uint64_t loadFailures;	// 加载失败次数
+	uint64_t evictions;		// 因超出内存上限淘汰的条目数
+	uint64_t expirations;	// 因过期删除的条目数
+	uint64_t invalidations; // 因标签失效删除的条目数
+
+	SZ_MysqlCacheStats() : entries(0), bytes(0), hits(0), misses(0), coalesced(0), loads(0), loadFailures(0), evictions(0), expirations(0), invalidations(0) {}
+};
+
+/**
+ * @brief 读穿透的查询结果缓存, 线程安全, 可在多个连接间共享
+ *        以规范化后的SQL与绑定参数为键, 每个条目有独立的过期时间, 超出内存上限时淘汰最久未用的条目
+ *        条目可带若干标签(通常为表名), 写入表后按标签失效; 加载期间其标签失效时结果不写入缓存, 其他标签的加载不受影响
+ *        同一键同时未命中时只有一个线程查询数据库, 其余线程等待其结果, 加载失败时一同抛出异常
+ *        失效之后到达的请求不会等待失效之前开始的加载, 而是重新加载
+ *        结果以shared_ptr<const SZ_DBTable>共享返回, 不拷贝; 被淘汰的结果在最后一个持有者释放时析构
+ *
+ *        SZ_MysqlCache cache(64 * 1024 * 1024, 60000);
+ *        SZ_MysqlCache::TablePtr user = cache.queryPrepared(mysql, "SELECT * FROM user WHERE id = ?", {id}, {"user"});
+ *        mysql.execute("UPDATE user SET ...");
+ *        cache.invalidate("user");
+ */
+class SZ_MysqlCache : public SZ_Uncopy
+{
+public:
+	typedef std::shared_ptr<const SZ_DBTable> TablePtr;
+	typedef std::function<SZ_DBTable()> Loader;
+
+public:
+	/**
+	 * @brief 构造
+	 *
+	 * @param maxBytes 内存上限, 按SZ_DBTable::memory与键长估算
+	 * @param defaultTtl 默认过期毫秒数, 小于0时不过期
+	 */
+	SZ_MysqlCache(size_t maxBytes = 64 * 1024 * 1024, int64_t defaultTtl = 60000);
+
+	~SZ_MysqlCache();
+
+	/**
+	 * @brief 查询, 未命中时以queryTable加载
+	 *
+	 * @param mysql
+	 * @param sSql
+	 * @param vTags 失效标签
+	 * @param ttl 过期毫秒数, 为0时取默认值, 小于0时不过期
+	 * @return TablePtr
+	 */
+	TablePtr query(SZ_Mysql &mysql, const std::string &sSql, const std::vector<std::string> &vTags = std::vector<std::string>(), int64_t ttl = 0);
+
+	/**
+	 * @brief 以预处理语句查询, 参数参与缓存键, 未命中时以prepare加载
+	 *
+	 * @param mysql
+	 * @param sSql
+	 * @param vParams
+	 * @param vTags 失效标签
+	 * @param ttl 过期毫秒数, 为0时取默认值, 小于0时不过期
+	 * @return TablePtr
+	 */
+	TablePtr queryPrepared(SZ_Mysql &mysql, const std::string &sSql, const std::vector<SZ_DBValue> &vParams,
+						   const std::vector<std::string> &vTags = std::vector<std::string>(), int64_t ttl = 0);
+
+	/**
+	 * @brief 按键取结果, 未命中时调用loader加载, loader抛出的异常原样抛出
+	 *
+	 * @param key 通常由makeKey生成
+	 * @param loader
+	 * @param vTags 失效标签
+	 * @param ttl 过期毫秒数, 为0时取默认值, 小于0时不过期
+	 * @return TablePtr
+	 */
+	TablePtr get(const std::string &key, const Loader &loader, const std::vector<std::string> &vTags = std::vector<std::string>(), int64_t ttl = 0);
+
+	/**
+	 * @brief 删除带有此标签的全部条目
+	 *
+	 * @param tag
+	 * @return size_t 删除的条目数
+	 */
+	size_t invalidate(const std::string &tag);
+
+	/**
+	 * @brief 清空缓存
+	 */
+	void clear();
+
+	/**
+	 * @brief 统计信息
+	 *
+	 * @return SZ_MysqlCacheStats
+	 */
+	SZ_MysqlCacheStats stats();
+
+	/**
+	 * @brief 缓存键, 首字节'T'或'P'区分文本查询与预处理语句, 之后为规范化后的SQL, 再依次为各参数的类型与内容
+	 *
+	 * @param sSql
+	 * @param vParams
+	 * @param prepared 是否为预处理语句
+	 * @return std::string
+	 */
+	static std::string makeKey(const std::string &sSql, const std::vector<SZ_DBValue> &vParams = std::vector<SZ_DBValue>(), bool prepared = false);
+
+	/**
+	 * @brief 规范化SQL: 去掉首尾空白, 引号外的连续空白合并为一个空格, 不改变大小写与引号内的内容
+	 *
+	 * @param sSql
+	 * @return std::string
+	 */
+	static std::string normalize(const std::string &sSql);
+
+protected:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Entry
+	{
+		std::string key;
+		TablePtr table;
+		std::vector<std::string> vTags;
+		bool expires;
+		Clock::time_point expireAt;
+		size_t bytes;
+	};
+
+	typedef std::list<Entry> EntryList;
+
+	/**
+	 * @brief 进行中的加载
+	 */
+	struct Loading
+	{
+		std::shared_future<TablePtr> future;
+		std::vector<std::string> vTags;
+		bool stale; // 加载期间标签失效或缓存被清空, 结果不写入
+	};
+
+	/**
+	 * @brief 加载结束, 从mapLoading_移除, 需持有mtx_
+	 *
+	 * @param key
+	 * @param loading
+	 */
+	void finishLoading(const std::string &key, const std::shared_ptr<Loading> &loading);
+
+	/**
+	 * @brief 删除条目, 需持有mtx_
+	 *
+	 * @param it
+	 */
+	void erase(EntryList::iterator it);
+
+	/**
+	 * @brief 写入条目并按内存上限淘汰, 需持有mtx_
+	 *
+	 * @param key
+	 * @param table
+	 * @param vTags
+	 * @param ttl
+	 */
+	void insert(const std::string &key, const TablePtr &table, const std::vector<std::string> &vTags, int64_t ttl);
+
+private:
+	size_t maxBytes_;
+	int64_t defaultTtl_;
+
+	std::mutex mtx_;
+	EntryList lstEntries_;												  // 最近使用的在前
+	std::unordered_map<std::string, EntryList::iterator> mapEntries_;	  // 键 -> lstEntries_中的位置
+	std::unordered_map<std::string, std::unordered_set<std::string>> mapTags_; // 标签 -> 键
+	std::unordered_map<std::string, std::shared_ptr<Loading>> mapLoading_;	  // 正在加载的键, 失效时移除
+	SZ_MysqlCacheStats stats_;
+};
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,268 @@
+#include "SZMysqlLoader.h"
+
+#if defined SZ_USE_MYSQL
+
+#include <cmath>
+#include <cstdio>
+
+SZ_MysqlLoader::SZ_MysqlLoader(SZ_Mysql *mysql, const std::string &sTable, const std::vector<std::string> &vColumns)
+    : mysql_(mysql), table_(sTable), vColumns_(vColumns), replace_(false), bufferSize_(64 * 1024)
+{
+    if (vColumns_.empty())
+    {
+        throw SZ_Mysql_Exception("Load into " + table_ + " has no columns");
+    }
+}
+
+SZ_MysqlLoader::~SZ_MysqlLoader()
+{
+}
+
+void SZ_MysqlLoader::setReplace(bool replace)
+{
+    replace_ = replace;
+}
+
+void SZ_MysqlLoader::setBufferSize(size_t bytes)
+{
+    bufferSize_ = std::max<size_t>(1, bytes);
+}
+
+SZ_MysqlLoadResult SZ_MysqlLoader::load(const RowSource &source)
+{
+    std::string sSql = "LOAD DATA LOCAL INFILE 'sz_loader' ";
+    sSql += replace_ ? "REPLACE" : "IGNORE";
+    sSql += " INTO TABLE " + table_;
+    sSql += " CHARACTER SET binary FIELDS TERMINATED BY '\\t' ESCAPED BY '\\\\' LINES TERMINATED BY '\\n' (";
+    for (size_t i = 0; i < vColumns_.size(); ++i)
+    {
+        if (i > 0)
+        {
+            sSql += ",";
+        }
+        sSql += vColumns_[i];
+    }
+    sSql += ")";
+
+    // 服务端按握手时的能力位决定是否允许LOCAL, 连接建立后再设置选项已来不及
+    if (0 == (mysql_->config().clientFlag & CLIENT_LOCAL_FILES))
+    {
+        throw SZ_Mysql_Exception("Load into " + table_ + " requires CLIENT_LOCAL_FILES in SZ_DBConfig::clientFlag");
+    }
+
+    if (!mysql_->isConnected())
+    {
+        mysql_->connect();
+    }
+    MYSQL *handle = mysql_->handle();
+
+    // 客户端只在本次导入期间响应服务端的读文件请求
+    unsigned int enable = 1;
+    if (mysql_options(handle, MYSQL_OPT_LOCAL_INFILE, &enable))
+    {
+        throw SZ_Mysql_Exception("mysql_options MYSQL_OPT_LOCAL_INFILE: [" + SZ_Mysql::mysqlError(handle) + "]");
+    }
+
+    Context context;
+    context.loader = this;
+    context.source = &source;
+    context.offset = 0;
+    context.eof = false;
+
+    mysql_set_local_infile_handler(handle, &SZ_MysqlLoader::onInit, &SZ_MysqlLoader::onRead, &SZ_MysqlLoader::onEnd, &SZ_MysqlLoader::onError, &context);
+    int iRet = mysql_real_query(handle, sSql.c_str(), sSql.length());
+    mysql_set_local_infile_default(handle);
+
+    // 默认处理函数会读取服务端指定的真实文件, 关闭失败时连接不能再用
+    unsigned int disable = 0;
+    if (mysql_options(handle, MYSQL_OPT_LOCAL_INFILE, &disable))
+    {
+        std::string sErr = SZ_Mysql::mysqlError(handle);
+        mysql_->disconnect();
+        throw SZ_Mysql_Exception("mysql_options MYSQL_OPT_LOCAL_INFILE: [" + sErr + "]");
+    }
+
+    if (context.exception)
+    {
+        std::rethrow_exception(context.exception);
+    }
+    if (iRet != 0)
+    {
+        throw SZ_Mysql_Exception("mysql_real_query: [ " + sSql + " ] [" + SZ_Mysql::mysqlError(handle) + "]");
+    }
+
+    SZ_MysqlLoadResult result = context.result;
+    result.affectedRows = mysql_affected_rows(handle);
+
+    // Records: 3  Deleted: 0  Skipped: 0  Warnings: 0
+    const char *info = mysql_info(handle);
+    unsigned long long records = 0, deleted = 0, skipped = 0, warnings = 0;
+    if (nullptr != info && sscanf(info, "Records: %llu Deleted: %llu Skipped: %llu Warnings: %llu", &records, &deleted, &skipped, &warnings) == 4)
+    {
+        result.records = records;
+        result.deleted = deleted;
+        result.skipped = skipped;
+        result.warnings = warnings;
+    }
+
+    return result;
+}
+
+int SZ_MysqlLoader::onInit(void **ptr, const char *, void *userdata)
+{
+    *ptr = userdata;
+    return 0;
+}
+
+int SZ_MysqlLoader::onRead(void *ptr, char *buf, unsigned int length)
+{
+    Context &context = *static_cast<Context *>(ptr);
+    if (context.offset == context.buffer.size())
+    {
+        if (context.eof)
+        {
+            return 0;
+        }
+
+        // 回调由C代码调用, 异常不能穿过, 记下后在load中重新抛出
+        try
+        {
+            context.loader->fill(context);
+        }
+        catch (const std::exception &e)
+        {
+            context.error = e.what();
+            context.exception = std::current_exception();
+            return -1;
+        }
+        catch (...)
+        {
+            context.error = "Row source failed";
+            context.exception = std::current_exception();
+            return -1;
+        }
+
+        if (context.buffer.empty())
+        {
+            return 0;
+        }
+    }
+
+    size_t n = std::min<size_t>(length, context.buffer.size() - context.offset);
+    memcpy(buf, context.buffer.data() + context.offset, n);
+    context.offset += n;
+    context.result.bytes += n;
+
+    return static_cast<int>(n);
+}
+
+void SZ_MysqlLoader::onEnd(void *)
+{
+}
+
+int SZ_MysqlLoader::onError(void *ptr, char *msg, unsigned int length)
+{
+    Context &context = *static_cast<Context *>(ptr);
+    snprintf(msg, length, "%s", context.error.c_str());
+    return 2000; // CR_UNKNOWN_ERROR
+}
+
+void SZ_MysqlLoader::fill(Context &context)
+{
+    context.buffer.clear();
+    context.offset = 0;
+
+    while (context.buffer.size() < bufferSize_)
+    {
+        const std::vector<SZ_DBValue> *row = (*context.source)();
+        if (nullptr == row)
+        {
+            context.eof = true;
+            break;
+        }
+
+        if (row->size() != vColumns_.size())
+        {
+            throw SZ_Mysql_Exception("Load into " + table_ + " expects " + SZ_Common::toString(vColumns_.size()) + " values, got " +
+                                     SZ_Common::toString(row->size()) + " at row " + SZ_Common::toString(context.result.rows));
+        }
+
+        for (size_t i = 0; i < row->size(); ++i)
+        {
+            if (i > 0)
+            {
+                context.buffer += '\t';
+            }
+            appendField(context.buffer, (*row)[i]);
+        }
+        context.buffer += '\n';
+        ++context.result.rows;
+    }
+}
+
+void SZ_MysqlLoader::appendField(std::string &buffer, const SZ_DBValue &value)
+{
+    char buf[32];
+    int len = 0;
+    switch (value.type())
+    {
+    case SZ_DBValue::TYPE_NULL:
+        buffer += "\\N";
+        break;
+    case SZ_DBValue::TYPE_INT:
+        len = snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value.toInt()));
+        buffer.append(buf, len);
+        break;
+    case SZ_DBValue::TYPE_UINT:
+        len = snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value.toUInt()));
+        buffer.append(buf, len);
+        break;
+    case SZ_DBValue::TYPE_DOUBLE:
+        if (!std::isfinite(value.toDouble()))
+        {
+            throw SZ_Mysql_Exception("Load into " + table_ + " can not store non-finite double");
+        }
+        len = snprintf(buf, sizeof(buf), "%.17g", value.toDouble());
+        buffer.append(buf, len);
+        break;
+    case SZ_DBValue::TYPE_STRING:
+    case SZ_DBValue::TYPE_BLOB:
+    {
+        // 只转义分隔符, 转义符本身和NUL, 其余字节原样写入
+        const char *data = static_cast<const char *>(value.data());
+        size_t size = value.size();
+        size_t start = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            const char *escape = nullptr;
+            switch (data[i])
+            {
+            case '\\':
+                escape = "\\\\";
+                break;
+            case '\t':
+                escape = "\\t";
+                break;
+            case '\n':
+                escape = "\\n";
+                break;
+            case '\r':
+                escape = "\\r";
+                break;
+            case '\0':
+                escape = "\\0";
+                break;
+            default:
+                continue;
+            }
+            buffer.append(data + start, i - start);
+            buffer.append(escape, 2);
+            start = i + 1;
+        }
+        buffer.append(data + start, size - start);
+        break;
+    }
+    }
+}
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,152 @@
+#pragma once
+
+#if defined SZ_USE_MYSQL
+
+#include "SZMysql.h"
+
+#include <exception>
+
+/**
+ * @brief 批量导入结果
+ */
+struct SZ_MysqlLoadResult
+{
+	uint64_t rows;		   // 发送的行数
+	uint64_t bytes;		   // 发送的字节数
+	uint64_t affectedRows; // 影响的行数, REPLACE时被替换的行计2
+	uint64_t records;	   // 服务端读到的行数
+	uint64_t deleted;	   // REPLACE删除的行数
+	uint64_t skipped;	   // 因键冲突跳过的行数
+	uint64_t warnings;	   // 警告数
+
+	SZ_MysqlLoadResult() : rows(0), bytes(0), affectedRows(0), records(0), deleted(0), skipped(0), warnings(0) {}
+};
+
+/**
+ * @brief 以LOAD DATA LOCAL INFILE批量导入, 行通过客户端的local infile回调边生成边发送, 不落临时文件
+ *        字段以制表符分隔, 行以换行分隔, 特殊字符以反斜杠转义, NULL写为\N, 按binary字符集导入不做转换
+ *        服务端须开启local_infile, 连接配置的clientFlag须含CLIENT_LOCAL_FILES, 建立连接时才会声明此能力
+ *        客户端只在导入期间响应服务端的读文件请求, 结束后关闭, 连接放回连接池后服务端无法借此读取客户端文件
+ *        键冲突默认跳过, 与LOAD DATA LOCAL的行为一致
+ *        导入期间独占连接, 中途断开不重试, 因为已读出的行无法重放
+ *
+ *        std::vector<std::vector<SZ_DBValue>> vRows = ...;
+ *        config.clientFlag |= CLIENT_LOCAL_FILES;
+ *        mysql.initialize(config);
+ *        SZ_MysqlLoader loader(&mysql, "user", {"id", "name", "score"});
+ *        SZ_MysqlLoadResult result = loader.load(vRows.begin(), vRows.end());
+ */
+class SZ_MysqlLoader : public SZ_Uncopy
+{
+public:
+	/**
+	 * @brief 行来源, 每次返回下一行, 没有更多行时返回nullptr
+	 *        返回的行在下一次调用前有效
+	 */
+	typedef std::function<const std::vector<SZ_DBValue> *()> RowSource;
+
+public:
+	/**
+	 * @brief 构造
+	 *
+	 * @param mysql 须比本对象存活更久
+	 * @param sTable 表名, 原样写入SQL
+	 * @param vColumns 列名, 原样写入SQL
+	 */
+	SZ_MysqlLoader(SZ_Mysql *mysql, const std::string &sTable, const std::vector<std::string> &vColumns);
+
+	~SZ_MysqlLoader();
+
+	/**
+	 * @brief 键冲突时替换已有行, 默认跳过
+	 *
+	 * @param replace
+	 */
+	void setReplace(bool replace);
+
+	/**
+	 * @brief 每次回调攒够多少字节再交给客户端库, 默认64KB
+	 *
+	 * @param bytes
+	 */
+	void setBufferSize(size_t bytes);
+
+	/**
+	 * @brief 导入, 失败或clientFlag不含CLIENT_LOCAL_FILES时抛出SZ_Mysql_Exception, 行来源抛出的异常原样抛出
+	 *        失败时服务端已收到的行是否保留取决于表引擎与事务
+	 *
+	 * @param source
+	 * @return SZ_MysqlLoadResult
+	 */
+	SZ_MysqlLoadResult load(const RowSource &source);
+
+	/**
+	 * @brief 导入迭代器区间内的行
+	 *
+	 * @tparam Iterator 解引用为std::vector<SZ_DBValue>
+	 * @param first
+	 * @param last
+	 * @return SZ_MysqlLoadResult
+	 */
+	template <typename Iterator>
+	SZ_MysqlLoadResult load(Iterator first, Iterator last)
+	{
+		return load([&first, &last]() -> const std::vector<SZ_DBValue> * {
+			if (first == last)
+			{
+				return nullptr;
+			}
+			const std::vector<SZ_DBValue> *row = &*first;
+			++first;
+			return row;
+		});
+	}
+
+protected:
+	/**
+	 * @brief 一次导入的状态, 在回调间传递
+	 */
+	struct Context
+	{
+		SZ_MysqlLoader *loader;
+		const RowSource *source;
+		std::string buffer; // 已格式化未发送的数据
+		size_t offset;		// buffer中已发送的位置
+		bool eof;
+		std::string error;
+		std::exception_ptr exception;
+		SZ_MysqlLoadResult result;
+	};
+
+	static int onInit(void **ptr, const char *filename, void *userdata);
+
+	static int onRead(void *ptr, char *buf, unsigned int length);
+
+	static void onEnd(void *ptr);
+
+	static int onError(void *ptr, char *msg, unsigned int length);
+
+	/**
+	 * @brief 从行来源取行并格式化, 直到缓冲达到设定大小或没有更多行
+	 *
+	 * @param context
+	 */
+	void fill(Context &context);
+
+	/**
+	 * @brief 追加一个字段
+	 *
+	 * @param buffer
+	 * @param value
+	 */
+	void appendField(std::string &buffer, const SZ_DBValue &value);
+
+private:
+	SZ_Mysql *mysql_;
+	std::string table_;
+	std::vector<std::string> vColumns_;
+	bool replace_;
+	size_t bufferSize_;
+};
+
+#endif // SZ_USE_MYSQL
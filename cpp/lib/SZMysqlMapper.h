@@ -0,0 +1,447 @@
+#pragma once
+
+#if defined SZ_USE_MYSQL
+
+#include "SZMysql.h"
+
+#include <array>
+#include <cstdlib>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @brief 单元格到C++类型的转换, 直接解析原始字节, 不构造中间字符串
+ *        NULL转换为类型的默认值; 内容不合法或超出范围时返回false
+ */
+struct SZ_DBParser
+{
+	static bool parse(const SZ_DBCell &cell, std::string &value)
+	{
+		if (cell.isNull())
+		{
+			value.clear();
+		}
+		else
+		{
+			value.assign(cell.data, cell.length);
+		}
+		return true;
+	}
+
+	static bool parse(const SZ_DBCell &cell, bool &value)
+	{
+		int64_t v = 0;
+		if (!parse(cell, v))
+		{
+			return false;
+		}
+		value = v != 0;
+		return true;
+	}
+
+	template <typename I>
+	static typename std::enable_if<std::is_integral<I>::value, bool>::type parse(const SZ_DBCell &cell, I &value)
+	{
+		if (cell.isNull())
+		{
+			value = I();
+			return true;
+		}
+
+		bool negative = false;
+		uint64_t magnitude = 0;
+		if (!parseInteger(cell.data, cell.length, negative, magnitude))
+		{
+			return false;
+		}
+
+		if (negative)
+		{
+			// 无符号类型只接受-0
+			uint64_t limit = std::is_signed<I>::value ? static_cast<uint64_t>(std::numeric_limits<I>::max()) + 1 : 0;
+			if (magnitude > limit)
+			{
+				return false;
+			}
+			value = magnitude == 0 ? I() : static_cast<I>(-static_cast<int64_t>(magnitude - 1) - 1);
+		}
+		else
+		{
+			if (magnitude > static_cast<uint64_t>(std::numeric_limits<I>::max()))
+			{
+				return false;
+			}
+			value = static_cast<I>(magnitude);
+		}
+		return true;
+	}
+
+	static bool parse(const SZ_DBCell &cell, double &value)
+	{
+		if (cell.isNull())
+		{
+			value = 0;
+			return true;
+		}
+		return parseDouble(cell.data, cell.length, value);
+	}
+
+	static bool parse(const SZ_DBCell &cell, float &value)
+	{
+		double v = 0;
+		if (!parse(cell, v))
+		{
+			return false;
+		}
+		value = static_cast<float>(v);
+		return true;
+	}
+
+	/**
+	 * @brief 解析十进制整数, 允许前导正负号
+	 *
+	 * @param data
+	 * @param length
+	 * @param negative
+	 * @param magnitude 绝对值
+	 * @return bool 超出uint64范围时返回false
+	 */
+	static bool parseInteger(const char *data, size_t length, bool &negative, uint64_t &magnitude)
+	{
+		size_t i = 0;
+		negative = false;
+		if (length > 0 && (data[0] == '-' || data[0] == '+'))
+		{
+			negative = data[0] == '-';
+			i = 1;
+		}
+		if (i == length)
+		{
+			return false;
+		}
+
+		uint64_t v = 0;
+		for (; i < length; ++i)
+		{
+			unsigned int d = static_cast<unsigned char>(data[i]) - '0';
+			if (d > 9 || v > (std::numeric_limits<uint64_t>::max() - d) / 10)
+			{
+				return false;
+			}
+			v = v * 10 + d;
+		}
+
+		magnitude = v;
+		return true;
+	}
+
+	/**
+	 * @brief 解析浮点数
+	 *        有效数字不超过2^53且十进制指数不超过22时, 一次精确的乘或除即得正确舍入的结果
+	 *        其余情况交给strtod
+	 *
+	 * @param data
+	 * @param length
+	 * @param value
+	 * @return bool
+	 */
+	static bool parseDouble(const char *data, size_t length, double &value)
+	{
+		static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+									   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+		size_t i = 0;
+		bool negative = false;
+		if (i < length && (data[i] == '-' || data[i] == '+'))
+		{
+			negative = data[i] == '-';
+			++i;
+		}
+
+		uint64_t mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool any = false;
+		for (; i < length && data[i] >= '0' && data[i] <= '9'; ++i)
+		{
+			any = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<unsigned int>(data[i] - '0');
+				digits += mantissa != 0 ? 1 : 0;
+			}
+			else
+			{
+				++exponent;
+			}
+		}
+		if (i < length && data[i] == '.')
+		{
+			for (++i; i < length && data[i] >= '0' && data[i] <= '9'; ++i)
+			{
+				any = true;
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<unsigned int>(data[i] - '0');
+					digits += mantissa != 0 ? 1 : 0;
+					--exponent;
+				}
+			}
+		}
+		if (i < length && (data[i] == 'e' || data[i] == 'E'))
+		{
+			bool expNegative = false;
+			uint64_t expValue = 0;
+			if (!parseInteger(data + i + 1, length - i - 1, expNegative, expValue) || expValue > 100000)
+			{
+				return parseDoubleSlow(data, length, value);
+			}
+			exponent += expNegative ? -static_cast<int>(expValue) : static_cast<int>(expValue);
+			i = length;
+		}
+
+		if (!any || i != length)
+		{
+			return parseDoubleSlow(data, length, value);
+		}
+
+		if (digits >= 19 || mantissa > (1ULL << 53) || exponent < -22 || exponent > 22)
+		{
+			return parseDoubleSlow(data, length, value);
+		}
+
+		double v = static_cast<double>(mantissa);
+		v = exponent < 0 ? v / POW10[-exponent] : v * POW10[exponent];
+		value = negative ? -v : v;
+		return true;
+	}
+
+	static bool parseDoubleSlow(const char *data, size_t length, double &value)
+	{
+		char buf[64];
+		std::string str;
+		const char *s = buf;
+		if (length < sizeof(buf))
+		{
+			memcpy(buf, data, length);
+			buf[length] = '\0';
+		}
+		else
+		{
+			str.assign(data, length);
+			s = str.c_str();
+		}
+
+		char *end = nullptr;
+		value = strtod(s, &end);
+		return length > 0 && end == s + length;
+	}
+};
+
+/**
+ * @brief 列绑定, 列名对应结构体成员
+ */
+template <typename T, typename M>
+struct SZ_DBColumn
+{
+	typedef T Object;
+
+	const char *name;
+	M T::*member;
+};
+
+/**
+ * @brief 声明列绑定
+ *
+ * @tparam T
+ * @tparam M
+ * @param name 列名
+ * @param member 成员指针
+ * @return SZ_DBColumn<T, M>
+ */
+template <typename T, typename M>
+SZ_DBColumn<T, M> SZ_DBField(const char *name, M T::*member)
+{
+	SZ_DBColumn<T, M> column = {name, member};
+	return column;
+}
+
+/**
+ * @brief 结果行到结构体的映射, 列绑定在编译期展开, 每条查询只按列名解析一次序号
+ *        单元格直接从客户端库的行缓冲解析到成员, 不经过字符串或map
+ *        映射对象无状态, 可在多个线程间共享
+ *
+ *        struct User { int64_t id; std::string name; double score; };
+ *        static const auto USER_MAPPER = SZ_DBMakeMapper(SZ_DBField("id", &User::id),
+ *                                                        SZ_DBField("name", &User::name),
+ *                                                        SZ_DBField("score", &User::score));
+ *        std::vector<User> vUsers = USER_MAPPER.query(mysql, "SELECT id, name, score FROM user");
+ */
+template <typename T, typename... Columns>
+class SZ_DBMapper
+{
+public:
+	typedef std::array<size_t, sizeof...(Columns)> Indexes;
+
+public:
+	explicit SZ_DBMapper(const Columns &...columns) : columns_(columns...)
+	{
+	}
+
+	/**
+	 * @brief 按列名解析各绑定的列序号
+	 *
+	 * @param vFields 结果集列名
+	 * @return Indexes 缺少绑定的列时抛出SZ_Mysql_Exception
+	 */
+	Indexes resolve(const std::vector<std::string> &vFields) const
+	{
+		Indexes indexes;
+		resolveAt<0>(vFields, indexes);
+		return indexes;
+	}
+
+	/**
+	 * @brief 填充一行
+	 *
+	 * @tparam Row 以operator[](size_t)返回SZ_DBCell的类型, 如SZ_DBCursor, SZ_DBTable::Row
+	 * @param row
+	 * @param indexes
+	 * @param object
+	 */
+	template <typename Row>
+	void fill(const Row &row, const Indexes &indexes, T &object) const
+	{
+		fillAt<0>(row, indexes, object);
+	}
+
+	/**
+	 * @brief 流式查询并映射全部行
+	 *
+	 * @param mysql
+	 * @param sSql
+	 * @return std::vector<T>
+	 */
+	std::vector<T> query(SZ_Mysql &mysql, const std::string &sSql) const
+	{
+		SZ_DBCursor cursor = mysql.queryCursor(sSql);
+		Indexes indexes = resolve(cursor.fields());
+
+		std::vector<T> vObjects;
+		while (cursor.next())
+		{
+			vObjects.emplace_back();
+			fill(cursor, indexes, vObjects.back());
+		}
+
+		return vObjects;
+	}
+
+	/**
+	 * @brief 流式查询, 每行映射后调用一次回调, 对象在回调间复用
+	 *
+	 * @param mysql
+	 * @param sSql
+	 * @param callback 返回false时停止读取
+	 * @return uint64_t 回调的行数
+	 */
+	uint64_t queryEach(SZ_Mysql &mysql, const std::string &sSql, const std::function<bool(T &)> &callback) const
+	{
+		SZ_DBCursor cursor = mysql.queryCursor(sSql);
+		Indexes indexes = resolve(cursor.fields());
+
+		T object;
+		while (cursor.next())
+		{
+			fill(cursor, indexes, object);
+			if (!callback(object))
+			{
+				break;
+			}
+		}
+
+		return cursor.rows();
+	}
+
+	/**
+	 * @brief 映射已取回的结果集
+	 *
+	 * @param table
+	 * @return std::vector<T>
+	 */
+	std::vector<T> map(const SZ_DBTable &table) const
+	{
+		Indexes indexes = resolve(table.fields());
+
+		std::vector<T> vObjects(table.rows());
+		for (size_t i = 0; i < table.rows(); ++i)
+		{
+			fill(table[i], indexes, vObjects[i]);
+		}
+
+		return vObjects;
+	}
+
+private:
+	template <size_t I>
+	typename std::enable_if<(I < sizeof...(Columns))>::type resolveAt(const std::vector<std::string> &vFields, Indexes &indexes) const
+	{
+		const char *name = std::get<I>(columns_).name;
+		size_t i = 0;
+		while (i < vFields.size() && vFields[i] != name)
+		{
+			++i;
+		}
+		if (i == vFields.size())
+		{
+			throw SZ_Mysql_Exception("Field not found: \"" + std::string(name) + "\"");
+		}
+		indexes[I] = i;
+
+		resolveAt<I + 1>(vFields, indexes);
+	}
+
+	template <size_t I>
+	typename std::enable_if<(I == sizeof...(Columns))>::type resolveAt(const std::vector<std::string> &, Indexes &) const
+	{
+	}
+
+	template <size_t I, typename Row>
+	typename std::enable_if<(I < sizeof...(Columns))>::type fillAt(const Row &row, const Indexes &indexes, T &object) const
+	{
+		const auto &column = std::get<I>(columns_);
+		SZ_DBCell cell = row[indexes[I]];
+		if (!SZ_DBParser::parse(cell, object.*(column.member)))
+		{
+			throw SZ_Mysql_Exception("Field \"" + std::string(column.name) + "\" value \"" + cell.str() + "\" can not be converted");
+		}
+
+		fillAt<I + 1>(row, indexes, object);
+	}
+
+	template <size_t I, typename Row>
+	typename std::enable_if<(I == sizeof...(Columns))>::type fillAt(const Row &, const Indexes &, T &) const
+	{
+	}
+
+private:
+	std::tuple<Columns...> columns_;
+};
+
+/**
+ * @brief 由列绑定构造映射, 结构体类型取自第一个绑定
+ *
+ * @tparam Column
+ * @tparam Columns
+ * @param column
+ * @param columns
+ * @return SZ_DBMapper<typename Column::Object, Column, Columns...>
+ */
+template <typename Column, typename... Columns>
+SZ_DBMapper<typename Column::Object, Column, Columns...> SZ_DBMakeMapper(const Column &column, const Columns &...columns)
+{
+	return SZ_DBMapper<typename Column::Object, Column, Columns...>(column, columns...);
+}
+
+#endif // SZ_USE_MYSQL
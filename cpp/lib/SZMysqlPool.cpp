@@ -0,0 +1,346 @@
+#include "SZMysqlPool.h"
+
+#if defined SZ_USE_MYSQL
+
+#include <vector>
+
+static uint64_t elapsedNs(const std::chrono::steady_clock::time_point &start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+SZ_MysqlPool::Connection::Connection() : pool_(nullptr)
+{
+}
+
+SZ_MysqlPool::Connection::Connection(SZ_MysqlPool *pool, std::unique_ptr<SZ_Mysql> mysql) : pool_(pool), mysql_(std::move(mysql))
+{
+}
+
+SZ_MysqlPool::Connection::Connection(Connection &&other) noexcept : pool_(other.pool_), mysql_(std::move(other.mysql_))
+{
+    other.pool_ = nullptr;
+}
+
+SZ_MysqlPool::Connection &SZ_MysqlPool::Connection::operator=(Connection &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        pool_ = other.pool_;
+        mysql_ = std::move(other.mysql_);
+        other.pool_ = nullptr;
+    }
+
+    return *this;
+}
+
+SZ_MysqlPool::Connection::~Connection()
+{
+    release();
+}
+
+SZ_Mysql *SZ_MysqlPool::Connection::operator->() const
+{
+    return mysql_.get();
+}
+
+SZ_Mysql &SZ_MysqlPool::Connection::operator*() const
+{
+    return *mysql_;
+}
+
+SZ_Mysql *SZ_MysqlPool::Connection::get() const
+{
+    return mysql_.get();
+}
+
+SZ_MysqlPool::Connection::operator bool() const
+{
+    return nullptr != mysql_;
+}
+
+void SZ_MysqlPool::Connection::release()
+{
+    if (nullptr != pool_ && nullptr != mysql_)
+    {
+        pool_->giveBack(std::move(mysql_), false);
+    }
+    pool_ = nullptr;
+    mysql_.reset();
+}
+
+void SZ_MysqlPool::Connection::discard()
+{
+    if (nullptr != pool_ && nullptr != mysql_)
+    {
+        pool_->giveBack(std::move(mysql_), true);
+    }
+    pool_ = nullptr;
+    mysql_.reset();
+}
+
+SZ_MysqlPool::SZ_MysqlPool(const SZ_DBConfig &config, size_t minSize, size_t maxSize, int64_t idleTimeout, int64_t validateInterval)
+    : config_(config), minSize_(minSize), maxSize_(std::max<size_t>(1, std::max(minSize, maxSize))), idleTimeout_(idleTimeout),
+      validateInterval_(validateInterval), stop_(false)
+{
+    for (size_t i = 0; i < minSize_; ++i)
+    {
+        Idle idle;
+        idle.mysql = create();
+        idle.since = std::chrono::steady_clock::now();
+        idle_.push_back(std::move(idle));
+        ++stats_.total;
+    }
+
+    maintainer_ = std::thread(&SZ_MysqlPool::maintain, this);
+}
+
+SZ_MysqlPool::~SZ_MysqlPool()
+{
+    std::deque<Idle> idle;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        stop_ = true;
+        idle.swap(idle_);
+        stats_.total -= idle.size();
+    }
+    maintainCond_.notify_all();
+    cond_.notify_all();
+
+    if (maintainer_.joinable())
+    {
+        maintainer_.join();
+    }
+}
+
+SZ_MysqlPool::Connection SZ_MysqlPool::acquire(int64_t timeout)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(timeout < 0 ? 0 : timeout);
+    bool waited = false;
+
+    std::unique_lock<std::mutex> locker(mtx_);
+    while (true)
+    {
+        if (stop_)
+        {
+            throw SZ_Mysql_Exception("Connection pool is stopped");
+        }
+
+        if (!idle_.empty())
+        {
+            Idle idle = std::move(idle_.back());
+            idle_.pop_back();
+            ++stats_.active;
+            locker.unlock();
+
+            bool check = validateInterval_ >= 0 && std::chrono::steady_clock::now() - idle.since >= std::chrono::milliseconds(validateInterval_);
+            if (!check || validate(idle.mysql.get()))
+            {
+                locker.lock();
+                ++stats_.borrows;
+                if (waited)
+                {
+                    uint64_t ns = elapsedNs(start);
+                    stats_.waitNs += ns;
+                    stats_.maxWaitNs = std::max(stats_.maxWaitNs, ns);
+                }
+                return Connection(this, std::move(idle.mysql));
+            }
+
+            // 重连也失败, 关闭后让出名额
+            idle.mysql.reset();
+            locker.lock();
+            --stats_.active;
+            --stats_.total;
+            ++stats_.validationFailures;
+            cond_.notify_one();
+            continue;
+        }
+
+        if (stats_.total < maxSize_)
+        {
+            ++stats_.total;
+            ++stats_.active;
+            locker.unlock();
+
+            std::unique_ptr<SZ_Mysql> mysql;
+            try
+            {
+                mysql = create();
+            }
+            catch (...)
+            {
+                locker.lock();
+                --stats_.total;
+                --stats_.active;
+                ++stats_.createFailures;
+                cond_.notify_one();
+                throw;
+            }
+
+            locker.lock();
+            ++stats_.creates;
+            ++stats_.borrows;
+            if (waited)
+            {
+                uint64_t ns = elapsedNs(start);
+                stats_.waitNs += ns;
+                stats_.maxWaitNs = std::max(stats_.maxWaitNs, ns);
+            }
+            return Connection(this, std::move(mysql));
+        }
+
+        waited = true;
+        ++stats_.waiting;
+        bool timedOut = false;
+        if (timeout < 0)
+        {
+            cond_.wait(locker);
+        }
+        else
+        {
+            timedOut = cond_.wait_until(locker, deadline) == std::cv_status::timeout;
+        }
+        --stats_.waiting;
+
+        if (timedOut && idle_.empty() && stats_.total >= maxSize_)
+        {
+            ++stats_.timeouts;
+            uint64_t ns = elapsedNs(start);
+            stats_.waitNs += ns;
+            stats_.maxWaitNs = std::max(stats_.maxWaitNs, ns);
+            throw SZ_Mysql_Exception("Acquire connection timeout after " + SZ_Common::toString(timeout) + " ms, pool size: " + SZ_Common::toString(maxSize_));
+        }
+    }
+}
+
+SZ_MysqlPoolStats SZ_MysqlPool::stats()
+{
+    std::lock_guard<std::mutex> locker(mtx_);
+    SZ_MysqlPoolStats stats = stats_;
+    stats.idle = idle_.size();
+
+    return stats;
+}
+
+const SZ_DBConfig &SZ_MysqlPool::config() const
+{
+    return config_;
+}
+
+std::unique_ptr<SZ_Mysql> SZ_MysqlPool::create()
+{
+    std::unique_ptr<SZ_Mysql> mysql(new SZ_Mysql());
+    mysql->initialize(config_);
+    mysql->connect();
+
+    return mysql;
+}
+
+bool SZ_MysqlPool::validate(SZ_Mysql *mysql)
+{
+    if (mysql->ping())
+    {
+        return true;
+    }
+
+    try
+    {
+        mysql->connect();
+    }
+    catch (const SZ_Mysql_Exception &)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void SZ_MysqlPool::giveBack(std::unique_ptr<SZ_Mysql> mysql, bool broken)
+{
+    std::unique_lock<std::mutex> locker(mtx_);
+    --stats_.active;
+    if (broken || stop_)
+    {
+        --stats_.total;
+        locker.unlock();
+        cond_.notify_one();
+        mysql.reset();
+        return;
+    }
+
+    Idle idle;
+    idle.mysql = std::move(mysql);
+    idle.since = std::chrono::steady_clock::now();
+    idle_.push_back(std::move(idle));
+    locker.unlock();
+    cond_.notify_one();
+}
+
+void SZ_MysqlPool::maintain()
+{
+    // 回收精度取空闲超时的一半, 不低于100ms, 不高于1s
+    int64_t interval = idleTimeout_ > 0 ? std::min<int64_t>(1000, std::max<int64_t>(100, idleTimeout_ / 2)) : 1000;
+
+    std::unique_lock<std::mutex> locker(mtx_);
+    while (!stop_)
+    {
+        maintainCond_.wait_for(locker, std::chrono::milliseconds(interval));
+        if (stop_)
+        {
+            break;
+        }
+
+        // 队首空闲最久
+        std::vector<std::unique_ptr<SZ_Mysql>> vEvicted;
+        auto now = std::chrono::steady_clock::now();
+        while (idleTimeout_ > 0 && !idle_.empty() && stats_.total > minSize_ && now - idle_.front().since >= std::chrono::milliseconds(idleTimeout_))
+        {
+            vEvicted.push_back(std::move(idle_.front().mysql));
+            idle_.pop_front();
+            --stats_.total;
+            ++stats_.evictions;
+        }
+
+        size_t missing = stats_.total < minSize_ ? minSize_ - stats_.total : 0;
+        stats_.total += missing;
+        locker.unlock();
+
+        vEvicted.clear();
+
+        std::vector<std::unique_ptr<SZ_Mysql>> vCreated;
+        size_t failed = 0;
+        for (size_t i = 0; i < missing; ++i)
+        {
+            try
+            {
+                vCreated.push_back(create());
+            }
+            catch (const SZ_Mysql_Exception &)
+            {
+                ++failed;
+            }
+        }
+
+        locker.lock();
+        stats_.total -= failed;
+        stats_.createFailures += failed;
+        stats_.creates += vCreated.size();
+        for (auto &mysql : vCreated)
+        {
+            Idle idle;
+            idle.mysql = std::move(mysql);
+            idle.since = std::chrono::steady_clock::now();
+            idle_.push_back(std::move(idle));
+            cond_.notify_one();
+        }
+        if (failed > 0)
+        {
+            cond_.notify_all();
+        }
+    }
+}
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,177 @@
+#pragma once
+
+#if defined SZ_USE_MYSQL
+
+#include "SZMysql.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief 连接池统计
+ */
+struct SZ_MysqlPoolStats
+{
+	size_t total;				 // 当前连接数, 含正在建立的
+	size_t idle;				 // 空闲连接数
+	size_t active;				 // 已借出的连接数
+	size_t waiting;				 // 正在等待的借用者数
+	uint64_t borrows;			 // 借用成功次数
+	uint64_t creates;			 // 新建连接次数
+	uint64_t createFailures;	 // 新建连接失败次数
+	uint64_t evictions;			 // 因空闲超时关闭的连接数
+	uint64_t validationFailures; // 借用时检测到失效的连接数
+	uint64_t timeouts;			 // 等待超时次数
+	uint64_t waitNs;			 // 等待总时长
+	uint64_t maxWaitNs;			 // 单次最长等待
+
+	SZ_MysqlPoolStats() : total(0), idle(0), active(0), waiting(0), borrows(0), creates(0), createFailures(0), evictions(0),
+						  validationFailures(0), timeouts(0), waitNs(0), maxWaitNs(0) {}
+};
+
+/**
+ * @brief 线程安全的SZ_Mysql连接池
+ *        借出的连接由Connection持有, 析构时自动归还; 空闲连接后进先出, 冷连接先被回收
+ *        空闲超过idleTimeout且总数多于minSize的连接由后台线程关闭, 总数不足minSize时补齐
+ *        借出时若连接已空闲超过validateInterval, 先mysql_ping检测, 失效则重连, 重连失败则换一个连接
+ *        连接数已达maxSize时等待归还, 超时抛出SZ_Mysql_Exception
+ *        归还的连接应处于干净状态(无未读结果, 无未结束事务), 否则应调用discard
+ *        连接池须在所有借出的连接归还之后析构
+ */
+class SZ_MysqlPool : public SZ_Uncopy
+{
+public:
+	/**
+	 * @brief 借出的连接, 析构时归还
+	 */
+	class Connection
+	{
+	public:
+		Connection();
+
+		Connection(Connection &&other) noexcept;
+
+		Connection &operator=(Connection &&other) noexcept;
+
+		~Connection();
+
+		SZ_Mysql *operator->() const;
+
+		SZ_Mysql &operator*() const;
+
+		SZ_Mysql *get() const;
+
+		explicit operator bool() const;
+
+		/**
+		 * @brief 提前归还
+		 */
+		void release();
+
+		/**
+		 * @brief 关闭连接而不归还, 用于连接状态不确定时, 如事务中途出错
+		 */
+		void discard();
+
+	private:
+		friend class SZ_MysqlPool;
+
+		Connection(SZ_MysqlPool *pool, std::unique_ptr<SZ_Mysql> mysql);
+
+		SZ_MysqlPool *pool_;
+		std::unique_ptr<SZ_Mysql> mysql_;
+	};
+
+public:
+	/**
+	 * @brief 构造时建立minSize个连接, 失败时抛出SZ_Mysql_Exception
+	 *
+	 * @param config
+	 * @param minSize 最少保持的连接数
+	 * @param maxSize 最多连接数
+	 * @param idleTimeout 空闲超过此毫秒数的连接被回收, 不大于0时不回收
+	 * @param validateInterval 空闲超过此毫秒数的连接借出前先检测, 为0时每次借出都检测, 小于0时不检测
+	 */
+	SZ_MysqlPool(const SZ_DBConfig &config, size_t minSize = 1, size_t maxSize = 8, int64_t idleTimeout = 60000, int64_t validateInterval = 5000);
+
+	~SZ_MysqlPool();
+
+	/**
+	 * @brief 借出连接
+	 *
+	 * @param timeout 连接数已满时等待的毫秒数, -1为一直等待
+	 * @return Connection
+	 */
+	Connection acquire(int64_t timeout = -1);
+
+	/**
+	 * @brief 统计信息
+	 *
+	 * @return SZ_MysqlPoolStats
+	 */
+	SZ_MysqlPoolStats stats();
+
+	/**
+	 * @brief 配置项
+	 *
+	 * @return const SZ_DBConfig&
+	 */
+	const SZ_DBConfig &config() const;
+
+protected:
+	struct Idle
+	{
+		std::unique_ptr<SZ_Mysql> mysql;
+		std::chrono::steady_clock::time_point since;
+	};
+
+	/**
+	 * @brief 新建并连接
+	 *
+	 * @return std::unique_ptr<SZ_Mysql>
+	 */
+	std::unique_ptr<SZ_Mysql> create();
+
+	/**
+	 * @brief 检测空闲连接, 失效时重连
+	 *
+	 * @param mysql
+	 * @return bool 不可用时返回false
+	 */
+	bool validate(SZ_Mysql *mysql);
+
+	/**
+	 * @brief 归还连接
+	 *
+	 * @param mysql
+	 * @param broken 为true时关闭而不放回
+	 */
+	void giveBack(std::unique_ptr<SZ_Mysql> mysql, bool broken);
+
+	/**
+	 * @brief 后台回收空闲连接并补足最少连接数
+	 */
+	void maintain();
+
+private:
+	SZ_DBConfig config_;
+	size_t minSize_;
+	size_t maxSize_;
+	int64_t idleTimeout_;
+	int64_t validateInterval_;
+
+	std::mutex mtx_;
+	std::condition_variable cond_;		  // 有连接归还或名额空出
+	std::condition_variable maintainCond_; // 唤醒后台线程退出
+	bool stop_;
+	std::deque<Idle> idle_;
+	SZ_MysqlPoolStats stats_;
+
+	std::thread maintainer_;
+};
+
+#endif // SZ_USE_MYSQL
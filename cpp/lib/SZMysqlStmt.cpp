@@ -0,0 +1,589 @@
+#include "SZMysqlStmt.h"
+
+#if defined SZ_USE_MYSQL
+
+#include <cmath>
+
+static std::string stmtError(MYSQL_STMT *stmt)
+{
+    std::string str;
+    str += std::string("code:") + SZ_Common::toString(mysql_stmt_errno(stmt));
+    str += std::string(", message: ") + mysql_stmt_error(stmt);
+    str += std::string(", status: ") + mysql_stmt_sqlstate(stmt);
+    return str;
+}
+
+static bool isIntegerType(enum_field_types type)
+{
+    switch (type)
+    {
+    case MYSQL_TYPE_TINY:
+    case MYSQL_TYPE_SHORT:
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONG:
+    case MYSQL_TYPE_LONGLONG:
+    case MYSQL_TYPE_YEAR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 按文本协议的格式输出浮点数: 能还原该列精度的最短有效数字,
+ *        小数点位置在[-3, 15]之外时用指数形式, 指数不带'+'与前导0, 如 1.2 0.0001 1e-5 1e20
+ */
+static std::string formatFloating(double d, bool single)
+{
+    if (!std::isfinite(d))
+    {
+        return SZ_DBValue(d).toString();
+    }
+    if (0 == d)
+    {
+        return std::signbit(d) ? "-0" : "0";
+    }
+
+    // [-]d.ddde[+-]xx
+    char buf[32];
+    int maxDigits = single ? 9 : 17;
+    for (int digits = 1; digits <= maxDigits; ++digits)
+    {
+        snprintf(buf, sizeof(buf), "%.*e", digits - 1, d);
+        double back = strtod(buf, nullptr);
+        if (single ? static_cast<float>(back) == static_cast<float>(d) : back == d)
+        {
+            break;
+        }
+    }
+
+    const char *p = buf;
+    bool negative = '-' == *p;
+    if (negative)
+    {
+        ++p;
+    }
+    std::string sDigits;
+    for (; *p != 'e'; ++p)
+    {
+        if (*p != '.')
+        {
+            sDigits += *p;
+        }
+    }
+    int exponent = atoi(p + 1);
+    while (sDigits.size() > 1 && sDigits.back() == '0')
+    {
+        sDigits.pop_back();
+    }
+
+    std::string str = negative ? "-" : "";
+    int point = exponent + 1; // 小数点前的位数
+    if (point < -3 || point > 15)
+    {
+        str += sDigits[0];
+        if (sDigits.size() > 1)
+        {
+            str += '.';
+            str.append(sDigits, 1, std::string::npos);
+        }
+        str += 'e';
+        str += std::to_string(exponent);
+    }
+    else if (point <= 0)
+    {
+        str += "0.";
+        str.append(static_cast<size_t>(-point), '0');
+        str += sDigits;
+    }
+    else if (static_cast<size_t>(point) >= sDigits.size())
+    {
+        str += sDigits;
+        str.append(point - sDigits.size(), '0');
+    }
+    else
+    {
+        str.append(sDigits, 0, point);
+        str += '.';
+        str.append(sDigits, point, std::string::npos);
+    }
+
+    return str;
+}
+
+SZ_MysqlStmt::SZ_MysqlStmt(SZ_Mysql *mysql, const std::string &sSql)
+    : mysql_(mysql), sql_(sSql), stmt_(nullptr), generation_(0), hasResult_(false), hasRow_(false)
+{
+    prepare();
+}
+
+SZ_MysqlStmt::~SZ_MysqlStmt()
+{
+    close();
+}
+
+const std::string &SZ_MysqlStmt::sql() const
+{
+    return sql_;
+}
+
+size_t SZ_MysqlStmt::paramCount() const
+{
+    return vParams_.size();
+}
+
+SZ_MysqlStmt &SZ_MysqlStmt::bind(size_t index, const SZ_DBValue &value)
+{
+    if (index >= vParams_.size())
+    {
+        throw SZ_Mysql_Exception("Parameter index " + SZ_Common::toString(index) + " out of range: [" + sql_ + "]");
+    }
+
+    vParams_[index] = value;
+    vBound_[index] = true;
+    return *this;
+}
+
+void SZ_MysqlStmt::clearBindings()
+{
+    for (size_t i = 0; i < vParams_.size(); ++i)
+    {
+        vParams_[i] = SZ_DBValue();
+        vBound_[i] = false;
+    }
+}
+
+size_t SZ_MysqlStmt::execute()
+{
+    freeResult();
+
+    for (size_t i = 0; i < vBound_.size(); ++i)
+    {
+        if (!vBound_[i])
+        {
+            throw SZ_Mysql_Exception("Parameter " + SZ_Common::toString(i) + " not bound: [" + sql_ + "]");
+        }
+    }
+
+    if (nullptr == stmt_ || generation_ != mysql_->generation() || !mysql_->isConnected())
+    {
+        prepare();
+    }
+
+    bindParams();
+    int iRet = mysql_stmt_execute(stmt_);
+    if (iRet != 0 && SZ_Mysql::isConnectionLost(mysql_stmt_errno(stmt_)))
+    {
+        mysql_->connect();
+        prepare();
+        bindParams();
+        iRet = mysql_stmt_execute(stmt_);
+    }
+
+    if (iRet != 0)
+    {
+        throw SZ_Mysql_Exception("mysql_stmt_execute: [" + sql_ + "] [" + stmtError(stmt_) + "]");
+    }
+
+    if (mysql_stmt_field_count(stmt_) > 0)
+    {
+        storeResult();
+    }
+
+    return static_cast<size_t>(mysql_stmt_affected_rows(stmt_));
+}
+
+size_t SZ_MysqlStmt::execute(const std::vector<SZ_DBValue> &vParams)
+{
+    if (vParams.size() != vParams_.size())
+    {
+        throw SZ_Mysql_Exception("Expect " + SZ_Common::toString(vParams_.size()) + " parameters, got " + SZ_Common::toString(vParams.size()) + ": [" + sql_ + "]");
+    }
+
+    for (size_t i = 0; i < vParams.size(); ++i)
+    {
+        vParams_[i] = vParams[i];
+        vBound_[i] = true;
+    }
+
+    return execute();
+}
+
+bool SZ_MysqlStmt::fetch()
+{
+    hasRow_ = false;
+    if (!hasResult_)
+    {
+        return false;
+    }
+
+    int iRet = mysql_stmt_fetch(stmt_);
+    if (iRet == MYSQL_NO_DATA)
+    {
+        return false;
+    }
+    if (iRet == 1)
+    {
+        throw SZ_Mysql_Exception("mysql_stmt_fetch: [" + sql_ + "] [" + stmtError(stmt_) + "]");
+    }
+
+    // 理论上缓冲已按最大长度分配, 仍被截断时扩容后单独取该列
+    if (iRet == MYSQL_DATA_TRUNCATED)
+    {
+        bool rebind = false;
+        for (size_t i = 0; i < vColumns_.size(); ++i)
+        {
+            Column &col = vColumns_[i];
+            if (col.isNumber || !col.error || col.isNull)
+            {
+                continue;
+            }
+
+            col.buffer.resize(col.length + 1);
+            MYSQL_BIND &bind = vResultBinds_[i];
+            bind.buffer = col.buffer.data();
+            bind.buffer_length = col.length;
+            if (mysql_stmt_fetch_column(stmt_, &bind, static_cast<unsigned int>(i), 0) != 0)
+            {
+                throw SZ_Mysql_Exception("mysql_stmt_fetch_column: [" + sql_ + "] [" + stmtError(stmt_) + "]");
+            }
+            rebind = true;
+        }
+
+        if (rebind && mysql_stmt_bind_result(stmt_, vResultBinds_.data()))
+        {
+            throw SZ_Mysql_Exception("mysql_stmt_bind_result: [" + sql_ + "] [" + stmtError(stmt_) + "]");
+        }
+    }
+
+    // 字符串列补结束符, 以便按数值解析
+    for (auto &col : vColumns_)
+    {
+        if (!col.isNumber && !col.isNull)
+        {
+            col.buffer[std::min<size_t>(col.length, col.buffer.size() - 1)] = '\0';
+        }
+    }
+
+    hasRow_ = true;
+    return true;
+}
+
+void SZ_MysqlStmt::freeResult()
+{
+    if (hasResult_)
+    {
+        mysql_stmt_free_result(stmt_);
+        hasResult_ = false;
+    }
+    hasRow_ = false;
+}
+
+const std::vector<std::string> &SZ_MysqlStmt::fields() const
+{
+    return vFields_;
+}
+
+size_t SZ_MysqlStmt::index(const std::string &field) const
+{
+    for (size_t i = 0; i < vFields_.size(); ++i)
+    {
+        if (vFields_[i] == field)
+        {
+            return i;
+        }
+    }
+
+    throw SZ_Mysql_Exception("Field not found: \"" + field + "\"");
+}
+
+bool SZ_MysqlStmt::isNull(size_t col) const
+{
+    return column(col).isNull;
+}
+
+int64_t SZ_MysqlStmt::getInt(size_t col) const
+{
+    const Column &c = column(col);
+    if (c.isNull)
+    {
+        return 0;
+    }
+    if (isIntegerType(c.type))
+    {
+        return c.isUnsigned ? static_cast<int64_t>(c.num.u) : c.num.i;
+    }
+    if (c.isNumber)
+    {
+        return static_cast<int64_t>(c.num.d);
+    }
+
+    return strtoll(c.buffer.data(), nullptr, 10);
+}
+
+uint64_t SZ_MysqlStmt::getUInt(size_t col) const
+{
+    const Column &c = column(col);
+    if (c.isNull)
+    {
+        return 0;
+    }
+    if (isIntegerType(c.type))
+    {
+        return c.isUnsigned ? c.num.u : static_cast<uint64_t>(c.num.i);
+    }
+    if (c.isNumber)
+    {
+        return static_cast<uint64_t>(c.num.d);
+    }
+
+    return strtoull(c.buffer.data(), nullptr, 10);
+}
+
+double SZ_MysqlStmt::getDouble(size_t col) const
+{
+    const Column &c = column(col);
+    if (c.isNull)
+    {
+        return 0;
+    }
+    if (isIntegerType(c.type))
+    {
+        return c.isUnsigned ? static_cast<double>(c.num.u) : static_cast<double>(c.num.i);
+    }
+    if (c.isNumber)
+    {
+        return c.num.d;
+    }
+
+    return strtod(c.buffer.data(), nullptr);
+}
+
+std::string SZ_MysqlStmt::getString(size_t col) const
+{
+    const Column &c = column(col);
+    if (c.isNull)
+    {
+        return std::string();
+    }
+    if (isIntegerType(c.type))
+    {
+        return c.isUnsigned ? std::to_string(c.num.u) : std::to_string(c.num.i);
+    }
+    if (c.isNumber)
+    {
+        // FLOAT列以double取回, 1.2会变成1.2000000476837158, 按列的精度输出
+        return formatFloating(c.num.d, c.type == MYSQL_TYPE_FLOAT);
+    }
+
+    return std::string(c.buffer.data(), c.length);
+}
+
+size_t SZ_MysqlStmt::affectedRows()
+{
+    return nullptr != stmt_ ? static_cast<size_t>(mysql_stmt_affected_rows(stmt_)) : 0;
+}
+
+size_t SZ_MysqlStmt::lastInsertId()
+{
+    return nullptr != stmt_ ? static_cast<size_t>(mysql_stmt_insert_id(stmt_)) : 0;
+}
+
+void SZ_MysqlStmt::prepare()
+{
+    close();
+
+    if (!mysql_->isConnected())
+    {
+        mysql_->connect();
+    }
+
+    for (int attempt = 0;; ++attempt)
+    {
+        stmt_ = mysql_stmt_init(mysql_->handle());
+        if (nullptr == stmt_)
+        {
+            throw SZ_Mysql_Exception("mysql_stmt_init: [" + sql_ + "] out of memory");
+        }
+
+        if (mysql_stmt_prepare(stmt_, sql_.c_str(), sql_.length()) == 0)
+        {
+            break;
+        }
+
+        std::string sErr = stmtError(stmt_);
+        bool lost = SZ_Mysql::isConnectionLost(mysql_stmt_errno(stmt_));
+        close();
+        if (!lost || attempt > 0)
+        {
+            throw SZ_Mysql_Exception("mysql_stmt_prepare: [" + sql_ + "] [" + sErr + "]");
+        }
+        mysql_->connect();
+    }
+
+    // 读取结果集时统计各列最大长度, 以便一次分配足够的缓冲
+    SZ_MysqlBool updateMaxLength = 1;
+    mysql_stmt_attr_set(stmt_, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+
+    size_t count = mysql_stmt_param_count(stmt_);
+    if (vParams_.size() != count)
+    {
+        vParams_.assign(count, SZ_DBValue());
+        vBound_.assign(count, false);
+    }
+
+    vFields_.clear();
+    MYSQL_RES *meta = mysql_stmt_result_metadata(stmt_);
+    if (nullptr != meta)
+    {
+        MYSQL_FIELD *fields = mysql_fetch_fields(meta);
+        for (unsigned int i = 0; i < mysql_num_fields(meta); ++i)
+        {
+            vFields_.emplace_back(fields[i].name);
+        }
+        mysql_free_result(meta);
+    }
+
+    generation_ = mysql_->generation();
+}
+
+void SZ_MysqlStmt::close()
+{
+    hasResult_ = false;
+    hasRow_ = false;
+    if (nullptr != stmt_)
+    {
+        mysql_stmt_close(stmt_);
+        stmt_ = nullptr;
+    }
+}
+
+void SZ_MysqlStmt::bindParams()
+{
+    if (vParams_.empty())
+    {
+        return;
+    }
+
+    vParamBinds_.assign(vParams_.size(), MYSQL_BIND());
+    for (size_t i = 0; i < vParams_.size(); ++i)
+    {
+        const SZ_DBValue &value = vParams_[i];
+        MYSQL_BIND &bind = vParamBinds_[i];
+        bind.buffer = const_cast<void *>(value.data());
+        bind.buffer_length = static_cast<unsigned long>(value.size());
+
+        switch (value.type())
+        {
+        case SZ_DBValue::TYPE_NULL:
+            bind.buffer_type = MYSQL_TYPE_NULL;
+            break;
+        case SZ_DBValue::TYPE_INT:
+            bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            break;
+        case SZ_DBValue::TYPE_UINT:
+            bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            bind.is_unsigned = 1;
+            break;
+        case SZ_DBValue::TYPE_DOUBLE:
+            bind.buffer_type = MYSQL_TYPE_DOUBLE;
+            break;
+        case SZ_DBValue::TYPE_STRING:
+            bind.buffer_type = MYSQL_TYPE_STRING;
+            break;
+        case SZ_DBValue::TYPE_BLOB:
+            bind.buffer_type = MYSQL_TYPE_BLOB;
+            break;
+        }
+    }
+
+    if (mysql_stmt_bind_param(stmt_, vParamBinds_.data()))
+    {
+        throw SZ_Mysql_Exception("mysql_stmt_bind_param: [" + sql_ + "] [" + stmtError(stmt_) + "]");
+    }
+}
+
+void SZ_MysqlStmt::storeResult()
+{
+    if (mysql_stmt_store_result(stmt_) != 0)
+    {
+        throw SZ_Mysql_Exception("mysql_stmt_store_result: [" + sql_ + "] [" + stmtError(stmt_) + "]");
+    }
+    hasResult_ = true;
+
+    MYSQL_RES *meta = mysql_stmt_result_metadata(stmt_);
+    if (nullptr == meta)
+    {
+        throw SZ_Mysql_Exception("mysql_stmt_result_metadata: [" + sql_ + "] [" + stmtError(stmt_) + "]");
+    }
+
+    unsigned int count = mysql_num_fields(meta);
+    MYSQL_FIELD *fields = mysql_fetch_fields(meta);
+
+    vFields_.resize(count);
+    vColumns_.resize(count);
+    vResultBinds_.assign(count, MYSQL_BIND());
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const MYSQL_FIELD &field = fields[i];
+        Column &col = vColumns_[i];
+        MYSQL_BIND &bind = vResultBinds_[i];
+
+        vFields_[i] = field.name;
+        col.type = field.type;
+        col.isUnsigned = (field.flags & UNSIGNED_FLAG) != 0;
+        col.num.u = 0;
+        col.length = 0;
+        col.isNull = 0;
+        col.error = 0;
+
+        if (isIntegerType(field.type))
+        {
+            col.isNumber = true;
+            bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            bind.buffer = &col.num;
+            bind.is_unsigned = col.isUnsigned;
+        }
+        else if (field.type == MYSQL_TYPE_FLOAT || field.type == MYSQL_TYPE_DOUBLE)
+        {
+            col.isNumber = true;
+            bind.buffer_type = MYSQL_TYPE_DOUBLE;
+            bind.buffer = &col.num;
+        }
+        else
+        {
+            // 日期、定点数等由客户端库转为字符串
+            col.isNumber = false;
+            col.buffer.resize(std::max<unsigned long>(field.max_length, 1) + 1);
+            bind.buffer_type = (field.flags & BINARY_FLAG) != 0 ? MYSQL_TYPE_BLOB : MYSQL_TYPE_STRING;
+            bind.buffer = col.buffer.data();
+            bind.buffer_length = static_cast<unsigned long>(col.buffer.size() - 1);
+        }
+
+        bind.length = &col.length;
+        bind.is_null = &col.isNull;
+        bind.error = &col.error;
+    }
+    mysql_free_result(meta);
+
+    if (mysql_stmt_bind_result(stmt_, vResultBinds_.data()))
+    {
+        throw SZ_Mysql_Exception("mysql_stmt_bind_result: [" + sql_ + "] [" + stmtError(stmt_) + "]");
+    }
+}
+
+const SZ_MysqlStmt::Column &SZ_MysqlStmt::column(size_t col) const
+{
+    if (!hasRow_)
+    {
+        throw SZ_Mysql_Exception("No current row: [" + sql_ + "]");
+    }
+    if (col >= vColumns_.size())
+    {
+        throw SZ_Mysql_Exception("Column index " + SZ_Common::toString(col) + " out of range: [" + sql_ + "]");
+    }
+
+    return vColumns_[col];
+}
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,218 @@
+#pragma once
+
+#if defined SZ_USE_MYSQL
+
+#include "SZMysql.h"
+
+#include <type_traits>
+
+// MySQL 8.0起MYSQL_BIND中的标志为bool, 之前为my_bool
+typedef std::remove_pointer<decltype(MYSQL_BIND::is_null)>::type SZ_MysqlBool;
+
+/**
+ * @brief 预处理语句, 使用二进制协议, 参数与结果按类型绑定
+ *        整数列以int64/uint64接收, 浮点列以double接收, 其余列以字符串接收
+ *        结果集在执行后整体读到客户端, 读取期间连接可执行其他语句
+ *        连接重建后首次执行时自动重新预处理
+ */
+class SZ_MysqlStmt : public SZ_Uncopy
+{
+public:
+	/**
+	 * @brief 立即预处理, 失败时抛出SZ_Mysql_Exception
+	 *
+	 * @param mysql 须比本对象存活更久
+	 * @param sSql
+	 */
+	SZ_MysqlStmt(SZ_Mysql *mysql, const std::string &sSql);
+
+	~SZ_MysqlStmt();
+
+	/**
+	 * @brief SQL文本
+	 *
+	 * @return const std::string&
+	 */
+	const std::string &sql() const;
+
+	/**
+	 * @brief 参数个数
+	 *
+	 * @return size_t
+	 */
+	size_t paramCount() const;
+
+	/**
+	 * @brief 绑定参数, 执行后保留, 可只改变部分参数再次执行
+	 *
+	 * @param index 从0开始
+	 * @param value
+	 * @return SZ_MysqlStmt&
+	 */
+	SZ_MysqlStmt &bind(size_t index, const SZ_DBValue &value);
+
+	/**
+	 * @brief 清除已绑定的参数
+	 */
+	void clearBindings();
+
+	/**
+	 * @brief 以已绑定的参数执行
+	 *
+	 * @return size_t 影响的行数, 查询语句为结果行数
+	 */
+	size_t execute();
+
+	/**
+	 * @brief 绑定全部参数并执行
+	 *
+	 * @param vParams
+	 * @return size_t 影响的行数, 查询语句为结果行数
+	 */
+	size_t execute(const std::vector<SZ_DBValue> &vParams);
+
+	/**
+	 * @brief 读取下一行
+	 *
+	 * @return bool 没有更多行时返回false
+	 */
+	bool fetch();
+
+	/**
+	 * @brief 释放结果集
+	 */
+	void freeResult();
+
+	/**
+	 * @brief 结果列名
+	 *
+	 * @return const std::vector<std::string>&
+	 */
+	const std::vector<std::string> &fields() const;
+
+	/**
+	 * @brief 列名对应的序号
+	 *
+	 * @param field
+	 * @return size_t 不存在时抛出SZ_Mysql_Exception
+	 */
+	size_t index(const std::string &field) const;
+
+	/**
+	 * @brief 当前行的列是否为NULL
+	 *
+	 * @param col
+	 * @return bool
+	 */
+	bool isNull(size_t col) const;
+
+	/**
+	 * @brief 当前行的列值, NULL为0
+	 *
+	 * @param col
+	 * @return int64_t
+	 */
+	int64_t getInt(size_t col) const;
+
+	/**
+	 * @brief 当前行的列值, NULL为0
+	 *
+	 * @param col
+	 * @return uint64_t
+	 */
+	uint64_t getUInt(size_t col) const;
+
+	/**
+	 * @brief 当前行的列值, NULL为0
+	 *
+	 * @param col
+	 * @return double
+	 */
+	double getDouble(size_t col) const;
+
+	/**
+	 * @brief 当前行的列值, NULL为空串, 浮点列与文本协议的格式相同
+	 *
+	 * @param col
+	 * @return std::string
+	 */
+	std::string getString(size_t col) const;
+
+	/**
+	 * @brief 最近一次执行影响的行数
+	 *
+	 * @return size_t
+	 */
+	size_t affectedRows();
+
+	/**
+	 * @brief 最近一次执行产生的自增ID
+	 *
+	 * @return size_t
+	 */
+	size_t lastInsertId();
+
+protected:
+	struct Column
+	{
+		enum_field_types type;
+		bool isNumber;
+		bool isUnsigned;
+		union
+		{
+			int64_t i;
+			uint64_t u;
+			double d;
+		} num;
+		std::vector<char> buffer; // 字符串列的缓冲, 末尾多留1字节
+		unsigned long length;
+		SZ_MysqlBool isNull;
+		SZ_MysqlBool error;
+	};
+
+	/**
+	 * @brief 预处理, 连接断开时重连一次
+	 */
+	void prepare();
+
+	/**
+	 * @brief 关闭语句句柄
+	 */
+	void close();
+
+	/**
+	 * @brief 绑定参数到句柄
+	 */
+	void bindParams();
+
+	/**
+	 * @brief 读取结果集并绑定结果缓冲
+	 */
+	void storeResult();
+
+	/**
+	 * @brief 取列, 越界时抛出SZ_Mysql_Exception
+	 *
+	 * @param col
+	 * @return const Column&
+	 */
+	const Column &column(size_t col) const;
+
+private:
+	SZ_Mysql *mysql_;
+	std::string sql_;
+	MYSQL_STMT *stmt_;
+	uint64_t generation_; // 预处理时的连接序号
+
+	std::vector<SZ_DBValue> vParams_;
+	std::vector<bool> vBound_;
+	std::vector<MYSQL_BIND> vParamBinds_;
+
+	std::vector<std::string> vFields_;
+	std::vector<Column> vColumns_;
+	std::vector<MYSQL_BIND> vResultBinds_;
+	bool hasResult_;
+	bool hasRow_;
+};
+
+#endif // SZ_USE_MYSQL
@@ -0,0 +1,404 @@
+#include "SZReclaim.h"
+
+#include <algorithm>
+
+// 单线程累计多少个待释放节点后尝试回收
+static const size_t RETIRE_THRESHOLD = 64;
+
+struct SZ_EpochDomain::Record
+{
+    std::atomic<uint64_t> state; // 0为未进入临界区, 否则为 (纪元 << 1) | 1
+    std::atomic_bool active;
+    Record *next;
+    size_t nest;
+    std::vector<SZ_Retired> retired;
+    char padding[64]; // 避免与相邻分配共享缓存行
+
+    Record() : state(0), active(true), next(nullptr), nest(0) {}
+};
+
+struct SZ_HazardDomain::Record
+{
+    std::atomic<void *> hazards[SZ_HazardDomain::SLOT_NUM];
+    std::atomic_bool active;
+    Record *next;
+    std::vector<SZ_Retired> retired;
+    char padding[64];
+
+    Record() : active(true), next(nullptr)
+    {
+        for (auto &hazard : hazards)
+        {
+            hazard.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * @brief 线程本地的记录缓存, 线程退出时归还记录
+ */
+template <typename Domain>
+struct SZ_ReclaimLocal
+{
+    std::vector<std::pair<Domain *, typename Domain::Record *>> records;
+
+    ~SZ_ReclaimLocal()
+    {
+        for (auto &item : records)
+        {
+            item.first->release(item.second);
+        }
+    }
+
+    typename Domain::Record *find(Domain *domain)
+    {
+        for (auto &item : records)
+        {
+            if (item.first == domain)
+            {
+                return item.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+static thread_local SZ_ReclaimLocal<SZ_EpochDomain> epochLocal;
+static thread_local SZ_ReclaimLocal<SZ_HazardDomain> hazardLocal;
+
+/**
+ * @brief 复用已注销的记录, 没有则新建并挂到链表头
+ */
+template <typename Record>
+static Record *acquireRecord(std::atomic<Record *> &head)
+{
+    for (Record *record = head.load(std::memory_order_acquire); record != nullptr; record = record->next)
+    {
+        bool expected = false;
+        if (!record->active.load(std::memory_order_relaxed) && record->active.compare_exchange_strong(expected, true))
+        {
+            return record;
+        }
+    }
+
+    Record *record = new Record();
+    Record *first = head.load(std::memory_order_relaxed);
+    do
+    {
+        record->next = first;
+    } while (!head.compare_exchange_weak(first, record, std::memory_order_release, std::memory_order_relaxed));
+
+    return record;
+}
+
+template <typename Record>
+static void destroyRecords(std::atomic<Record *> &head)
+{
+    Record *record = head.exchange(nullptr);
+    while (record != nullptr)
+    {
+        Record *next = record->next;
+        for (auto &item : record->retired)
+        {
+            item.deleter(item.ptr);
+        }
+        delete record;
+        record = next;
+    }
+}
+
+SZ_EpochDomain::SZ_EpochDomain() : epoch_(1), records_(nullptr), pending_(0)
+{
+}
+
+SZ_EpochDomain::~SZ_EpochDomain()
+{
+    destroyRecords(records_);
+    for (auto &item : orphans_)
+    {
+        item.deleter(item.ptr);
+    }
+}
+
+SZ_EpochDomain &SZ_EpochDomain::instance()
+{
+    static SZ_EpochDomain domain;
+    return domain;
+}
+
+SZ_EpochDomain::Record *SZ_EpochDomain::local()
+{
+    Record *record = epochLocal.find(this);
+    if (nullptr == record)
+    {
+        record = acquireRecord(records_);
+        epochLocal.records.emplace_back(this, record);
+    }
+
+    return record;
+}
+
+void SZ_EpochDomain::pin()
+{
+    Record *record = local();
+    if (record->nest++ == 0)
+    {
+        record->state.store((epoch_.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void SZ_EpochDomain::unpin()
+{
+    Record *record = local();
+    if (--record->nest == 0)
+    {
+        record->state.store(0, std::memory_order_release);
+    }
+}
+
+void SZ_EpochDomain::retire(void *ptr, void (*deleter)(void *))
+{
+    Record *record = local();
+    record->retired.push_back(SZ_Retired{ptr, deleter, epoch_.load(std::memory_order_relaxed)});
+    ++pending_;
+
+    if (record->retired.size() >= RETIRE_THRESHOLD)
+    {
+        collect();
+    }
+}
+
+size_t SZ_EpochDomain::collect()
+{
+    tryAdvance();
+
+    size_t n = reclaim(local());
+
+    std::unique_lock<std::mutex> locker(orphanMtx_, std::try_to_lock);
+    if (locker.owns_lock() && !orphans_.empty())
+    {
+        uint64_t epoch = epoch_.load(std::memory_order_acquire);
+        size_t freed = 0;
+        std::vector<SZ_Retired> vRetired;
+        vRetired.swap(orphans_);
+        for (auto &item : vRetired)
+        {
+            if (item.epoch + 2 <= epoch)
+            {
+                item.deleter(item.ptr);
+                ++freed;
+            }
+            else
+            {
+                orphans_.push_back(item);
+            }
+        }
+        pending_ -= freed;
+        n += freed;
+    }
+
+    return n;
+}
+
+uint64_t SZ_EpochDomain::epoch() const
+{
+    return epoch_.load();
+}
+
+size_t SZ_EpochDomain::pending() const
+{
+    return pending_.load();
+}
+
+void SZ_EpochDomain::release(Record *record)
+{
+    record->nest = 0;
+    record->state.store(0, std::memory_order_release);
+    reclaim(record);
+
+    if (!record->retired.empty())
+    {
+        std::lock_guard<std::mutex> locker(orphanMtx_);
+        orphans_.insert(orphans_.end(), record->retired.begin(), record->retired.end());
+    }
+    record->retired.clear();
+    record->active.store(false, std::memory_order_release);
+}
+
+bool SZ_EpochDomain::tryAdvance()
+{
+    uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+    for (Record *record = records_.load(std::memory_order_acquire); record != nullptr; record = record->next)
+    {
+        uint64_t state = record->state.load(std::memory_order_seq_cst);
+        if ((state & 1) && (state >> 1) != epoch)
+        {
+            return false;
+        }
+    }
+
+    return epoch_.compare_exchange_strong(epoch, epoch + 1);
+}
+
+size_t SZ_EpochDomain::reclaim(Record *record)
+{
+    uint64_t epoch = epoch_.load(std::memory_order_acquire);
+
+    // 先换出再释放, deleter中再次retire不会影响遍历
+    std::vector<SZ_Retired> vRetired;
+    vRetired.swap(record->retired);
+
+    size_t n = 0;
+    for (auto &item : vRetired)
+    {
+        if (item.epoch + 2 <= epoch)
+        {
+            item.deleter(item.ptr);
+            ++n;
+        }
+        else
+        {
+            record->retired.push_back(item);
+        }
+    }
+    pending_ -= n;
+
+    return n;
+}
+
+SZ_HazardDomain::SZ_HazardDomain() : records_(nullptr), pending_(0), threads_(0)
+{
+}
+
+SZ_HazardDomain::~SZ_HazardDomain()
+{
+    destroyRecords(records_);
+    for (auto &item : orphans_)
+    {
+        item.deleter(item.ptr);
+    }
+}
+
+SZ_HazardDomain &SZ_HazardDomain::instance()
+{
+    static SZ_HazardDomain domain;
+    return domain;
+}
+
+SZ_HazardDomain::Record *SZ_HazardDomain::local()
+{
+    Record *record = hazardLocal.find(this);
+    if (nullptr == record)
+    {
+        record = acquireRecord(records_);
+        hazardLocal.records.emplace_back(this, record);
+        ++threads_;
+    }
+
+    return record;
+}
+
+std::atomic<void *> &SZ_HazardDomain::slotOf(size_t slot)
+{
+    if (slot >= SLOT_NUM)
+    {
+        throw SZ_Exception(__FUNCTION__, "hazard slot out of range: " + SZ_Common::toString(slot));
+    }
+    return local()->hazards[slot];
+}
+
+void SZ_HazardDomain::clear(size_t slot)
+{
+    slotOf(slot).store(nullptr, std::memory_order_release);
+}
+
+void SZ_HazardDomain::retire(void *ptr, void (*deleter)(void *))
+{
+    Record *record = local();
+    record->retired.push_back(SZ_Retired{ptr, deleter, 0});
+    ++pending_;
+
+    if (record->retired.size() >= threads_.load(std::memory_order_relaxed) * SLOT_NUM * 2 + RETIRE_THRESHOLD)
+    {
+        collect();
+    }
+}
+
+size_t SZ_HazardDomain::collect()
+{
+    size_t n = scan(local());
+
+    std::unique_lock<std::mutex> locker(orphanMtx_, std::try_to_lock);
+    if (locker.owns_lock() && !orphans_.empty())
+    {
+        Record orphan;
+        orphan.retired.swap(orphans_);
+        n += scan(&orphan);
+        orphans_.swap(orphan.retired);
+    }
+
+    return n;
+}
+
+size_t SZ_HazardDomain::pending() const
+{
+    return pending_.load();
+}
+
+void SZ_HazardDomain::release(Record *record)
+{
+    for (auto &hazard : record->hazards)
+    {
+        hazard.store(nullptr, std::memory_order_release);
+    }
+    scan(record);
+
+    if (!record->retired.empty())
+    {
+        std::lock_guard<std::mutex> locker(orphanMtx_);
+        orphans_.insert(orphans_.end(), record->retired.begin(), record->retired.end());
+    }
+    record->retired.clear();
+    --threads_;
+    record->active.store(false, std::memory_order_release);
+}
+
+size_t SZ_HazardDomain::scan(Record *record)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    std::vector<void *> vHazards;
+    for (Record *other = records_.load(std::memory_order_acquire); other != nullptr; other = other->next)
+    {
+        for (auto &hazard : other->hazards)
+        {
+            void *ptr = hazard.load(std::memory_order_acquire);
+            if (nullptr != ptr)
+            {
+                vHazards.push_back(ptr);
+            }
+        }
+    }
+    std::sort(vHazards.begin(), vHazards.end());
+
+    std::vector<SZ_Retired> vRetired;
+    vRetired.swap(record->retired);
+
+    size_t n = 0;
+    for (auto &item : vRetired)
+    {
+        if (std::binary_search(vHazards.begin(), vHazards.end(), item.ptr))
+        {
+            record->retired.push_back(item);
+        }
+        else
+        {
+            item.deleter(item.ptr);
+            ++n;
+        }
+    }
+    pending_ -= n;
+
+    return n;
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "SZUtility.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief 待释放节点
+ */
+struct SZ_Retired
+{
+    void *ptr;
+    void (*deleter)(void *);
+    uint64_t epoch;
+};
+
+/**
+ * @brief 基于纪元的内存回收
+ *        读者持有SZ_EpochGuard期间访问的节点不会被释放, 被retire的节点在所有线程推进两个纪元后释放
+ *        线程首次使用时自动登记, 线程退出时自动注销并把未释放的节点移交给域, SZ_ThreadPool的工作线程可直接使用
+ *        域的生命周期须长于使用它的线程, 一般使用instance()
+ */
+class SZ_EpochDomain : public SZ_Uncopy
+{
+public:
+    struct Record;
+
+    SZ_EpochDomain();
+
+    ~SZ_EpochDomain();
+
+    /**
+     * @brief 全局默认域
+     *
+     * @return SZ_EpochDomain&
+     */
+    static SZ_EpochDomain &instance();
+
+    /**
+     * @brief 进入临界区, 可嵌套
+     */
+    void pin();
+
+    /**
+     * @brief 离开临界区
+     */
+    void unpin();
+
+    /**
+     * @brief 延迟释放
+     *
+     * @param ptr
+     * @param deleter
+     */
+    void retire(void *ptr, void (*deleter)(void *));
+
+    template <typename T>
+    void retire(T *ptr)
+    {
+        retire(static_cast<void *>(ptr), [](void *p)
+               { delete static_cast<T *>(p); });
+    }
+
+    /**
+     * @brief 尝试推进纪元并释放当前线程与已退出线程中可回收的节点
+     *
+     * @return size_t 释放的节点数
+     */
+    size_t collect();
+
+    /**
+     * @brief 当前纪元
+     *
+     * @return uint64_t
+     */
+    uint64_t epoch() const;
+
+    /**
+     * @brief 等待回收的节点数, 仅为近似值
+     *
+     * @return size_t
+     */
+    size_t pending() const;
+
+    /**
+     * @brief 释放线程记录, 由线程退出时调用
+     *
+     * @param record
+     */
+    void release(Record *record);
+
+protected:
+    Record *local();
+
+    bool tryAdvance();
+
+    size_t reclaim(Record *record);
+
+private:
+    std::atomic<uint64_t> epoch_;
+    std::atomic<Record *> records_;
+    std::atomic<size_t> pending_;
+
+    std::mutex orphanMtx_;
+    std::vector<SZ_Retired> orphans_; // 已退出线程遗留的节点
+};
+
+/**
+ * @brief 纪元临界区守卫
+ */
+class SZ_EpochGuard : public SZ_Uncopy
+{
+public:
+    explicit SZ_EpochGuard(SZ_EpochDomain &domain = SZ_EpochDomain::instance()) : domain_(domain) { domain_.pin(); }
+
+    ~SZ_EpochGuard() { domain_.unpin(); }
+
+private:
+    SZ_EpochDomain &domain_;
+};
+
+/**
+ * @brief 风险指针内存回收
+ *        每个线程最多同时保护SLOT_NUM个指针, 未释放节点数不超过 线程数 * SLOT_NUM * 2 + 阈值, 内存有界
+ *        线程登记与注销规则同SZ_EpochDomain
+ */
+class SZ_HazardDomain : public SZ_Uncopy
+{
+public:
+    static constexpr size_t SLOT_NUM = 4;
+
+    struct Record;
+
+    SZ_HazardDomain();
+
+    ~SZ_HazardDomain();
+
+    /**
+     * @brief 全局默认域
+     *
+     * @return SZ_HazardDomain&
+     */
+    static SZ_HazardDomain &instance();
+
+    /**
+     * @brief 读取src并发布到第slot个风险指针, 返回时该指针已受保护
+     *
+     * @tparam T
+     * @param src
+     * @param slot
+     * @return T*
+     */
+    template <typename T>
+    T *protect(const std::atomic<T *> &src, size_t slot)
+    {
+        std::atomic<void *> &hazard = slotOf(slot);
+        T *ptr = src.load(std::memory_order_relaxed);
+        while (true)
+        {
+            hazard.store(ptr, std::memory_order_seq_cst);
+            T *again = src.load(std::memory_order_seq_cst);
+            if (again == ptr)
+            {
+                return ptr;
+            }
+            ptr = again;
+        }
+    }
+
+    /**
+     * @brief 清除第slot个风险指针
+     *
+     * @param slot
+     */
+    void clear(size_t slot);
+
+    /**
+     * @brief 延迟释放, 不被任何风险指针引用时释放
+     *
+     * @param ptr
+     * @param deleter
+     */
+    void retire(void *ptr, void (*deleter)(void *));
+
+    template <typename T>
+    void retire(T *ptr)
+    {
+        retire(static_cast<void *>(ptr), [](void *p)
+               { delete static_cast<T *>(p); });
+    }
+
+    /**
+     * @brief 扫描并释放当前线程与已退出线程中可回收的节点
+     *
+     * @return size_t 释放的节点数
+     */
+    size_t collect();
+
+    /**
+     * @brief 等待回收的节点数, 仅为近似值
+     *
+     * @return size_t
+     */
+    size_t pending() const;
+
+    /**
+     * @brief 释放线程记录, 由线程退出时调用
+     *
+     * @param record
+     */
+    void release(Record *record);
+
+protected:
+    Record *local();
+
+    std::atomic<void *> &slotOf(size_t slot);
+
+    size_t scan(Record *record);
+
+private:
+    std::atomic<Record *> records_;
+    std::atomic<size_t> pending_;
+    std::atomic<size_t> threads_;
+
+    std::mutex orphanMtx_;
+    std::vector<SZ_Retired> orphans_;
+};
+
+/**
+ * @brief 风险指针守卫, 析构时清除对应槽位
+ */
+class SZ_HazardGuard : public SZ_Uncopy
+{
+public:
+    explicit SZ_HazardGuard(size_t slot = 0, SZ_HazardDomain &domain = SZ_HazardDomain::instance()) : slot_(slot), domain_(domain) {}
+
+    ~SZ_HazardGuard() { domain_.clear(slot_); }
+
+    template <typename T>
+    T *protect(const std::atomic<T *> &src)
+    {
+        return domain_.protect(src, slot_);
+    }
+
+    void reset() { domain_.clear(slot_); }
+
+private:
+    size_t slot_;
+    SZ_HazardDomain &domain_;
+};
@@ -0,0 +1,299 @@
+#include "SZSemaphore.h"
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "futex word must be 32 bits");
+
+// 进入内核前的自旋次数
+static const int SPIN_COUNT = 64;
+
+static int64_t remaining(const std::chrono::steady_clock::time_point &deadline)
+{
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    return left > 0 ? left : 0;
+}
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+
+bool SZ_Futex::wait(std::atomic<int32_t> *addr, int32_t expected, int64_t timeout)
+{
+    struct timespec ts;
+    struct timespec *pts = nullptr;
+    if (timeout >= 0)
+    {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000;
+        pts = &ts;
+    }
+
+    long ret = syscall(SYS_futex, reinterpret_cast<int32_t *>(addr), FUTEX_WAIT_PRIVATE, expected, pts, nullptr, 0);
+    return !(ret != 0 && errno == ETIMEDOUT);
+}
+
+void SZ_Futex::wake(std::atomic<int32_t> *addr, int32_t n)
+{
+    syscall(SYS_futex, reinterpret_cast<int32_t *>(addr), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+}
+
+#else
+
+struct SZ_ParkingBucket
+{
+    std::mutex mtx;
+    std::condition_variable cond;
+};
+
+static SZ_ParkingBucket &parkingBucket(const void *addr)
+{
+    static SZ_ParkingBucket buckets[64];
+    return buckets[(reinterpret_cast<uintptr_t>(addr) >> 4) % 64];
+}
+
+bool SZ_Futex::wait(std::atomic<int32_t> *addr, int32_t expected, int64_t timeout)
+{
+    SZ_ParkingBucket &bucket = parkingBucket(addr);
+    std::unique_lock<std::mutex> locker(bucket.mtx);
+    if (addr->load() != expected)
+    {
+        return true;
+    }
+
+    if (timeout < 0)
+    {
+        bucket.cond.wait(locker);
+        return true;
+    }
+
+    return bucket.cond.wait_for(locker, std::chrono::milliseconds(timeout)) == std::cv_status::no_timeout;
+}
+
+void SZ_Futex::wake(std::atomic<int32_t> *addr, int32_t n)
+{
+    // 同一桶内可能有其他地址的等待者, 只能全部唤醒
+    (void)n;
+    SZ_ParkingBucket &bucket = parkingBucket(addr);
+    std::lock_guard<std::mutex> locker(bucket.mtx);
+    bucket.cond.notify_all();
+}
+
+#endif
+
+void SZ_Futex::wakeAll(std::atomic<int32_t> *addr)
+{
+    wake(addr, INT_MAX);
+}
+
+SZ_Semaphore::SZ_Semaphore(int32_t count) : count_(count), waiters_(0)
+{
+}
+
+SZ_Semaphore::~SZ_Semaphore()
+{
+}
+
+bool SZ_Semaphore::tryWait()
+{
+    int32_t count = count_.load(std::memory_order_relaxed);
+    while (count > 0)
+    {
+        if (count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SZ_Semaphore::wait(int64_t timeout)
+{
+    for (int i = 0; i < SPIN_COUNT; ++i)
+    {
+        if (tryWait())
+        {
+            return true;
+        }
+    }
+
+    if (timeout == 0)
+    {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+    ++waiters_;
+    while (!tryWait())
+    {
+        if (timeout < 0)
+        {
+            SZ_Futex::wait(&count_, 0);
+        }
+        else
+        {
+            int64_t left = remaining(deadline);
+            if (left == 0 || !SZ_Futex::wait(&count_, 0, left))
+            {
+                --waiters_;
+                return tryWait();
+            }
+        }
+    }
+    --waiters_;
+
+    return true;
+}
+
+void SZ_Semaphore::post(int32_t n)
+{
+    if (n <= 0)
+    {
+        return;
+    }
+
+    count_.fetch_add(n, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) > 0)
+    {
+        SZ_Futex::wake(&count_, n);
+    }
+}
+
+int32_t SZ_Semaphore::available() const
+{
+    return count_.load();
+}
+
+SZ_Latch::SZ_Latch(int32_t count) : count_(count), waiters_(0)
+{
+}
+
+SZ_Latch::~SZ_Latch()
+{
+}
+
+void SZ_Latch::countDown(int32_t n)
+{
+    int32_t count = count_.load(std::memory_order_relaxed);
+    while (count > 0)
+    {
+        int32_t next = count > n ? count - n : 0;
+        if (count_.compare_exchange_weak(count, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            if (next == 0 && waiters_.load(std::memory_order_seq_cst) > 0)
+            {
+                SZ_Futex::wakeAll(&count_);
+            }
+            return;
+        }
+    }
+}
+
+bool SZ_Latch::wait(int64_t timeout)
+{
+    for (int i = 0; i < SPIN_COUNT; ++i)
+    {
+        if (isReady())
+        {
+            return true;
+        }
+    }
+
+    if (timeout == 0)
+    {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+    ++waiters_;
+    int32_t count;
+    while ((count = count_.load(std::memory_order_acquire)) > 0)
+    {
+        if (timeout < 0)
+        {
+            SZ_Futex::wait(&count_, count);
+        }
+        else
+        {
+            int64_t left = remaining(deadline);
+            if (left == 0 || !SZ_Futex::wait(&count_, count, left))
+            {
+                --waiters_;
+                return isReady();
+            }
+        }
+    }
+    --waiters_;
+
+    return true;
+}
+
+void SZ_Latch::arriveAndWait()
+{
+    countDown(1);
+    wait();
+}
+
+bool SZ_Latch::isReady() const
+{
+    return count_.load(std::memory_order_acquire) == 0;
+}
+
+SZ_Barrier::SZ_Barrier(int32_t count) : total_(count > 0 ? count : 1), count_(total_), generation_(0), waiters_(0)
+{
+}
+
+SZ_Barrier::~SZ_Barrier()
+{
+}
+
+bool SZ_Barrier::arriveAndWait()
+{
+    int32_t generation = generation_.load(std::memory_order_acquire);
+
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // 先重置计数再推进轮次, 下一轮的线程只有看到新轮次后才会到达
+        count_.store(total_, std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) > 0)
+        {
+            SZ_Futex::wakeAll(&generation_);
+        }
+        return true;
+    }
+
+    for (int i = 0; i < SPIN_COUNT; ++i)
+    {
+        if (generation_.load(std::memory_order_acquire) != generation)
+        {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+
+    ++waiters_;
+    while (generation_.load(std::memory_order_acquire) == generation)
+    {
+        SZ_Futex::wait(&generation_, generation);
+    }
+    --waiters_;
+
+    return false;
+}
+
+int32_t SZ_Barrier::generation() const
+{
+    return generation_.load();
+}
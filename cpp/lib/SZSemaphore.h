@@ -0,0 +1,156 @@
+#pragma once
+
+#include "SZUtility.h"
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief 地址等待/唤醒
+ *        Linux下使用futex, 其他平台以按地址散列的互斥量与条件变量模拟
+ */
+class SZ_Futex
+{
+public:
+    /**
+     * @brief 当*addr等于expected时阻塞, 直到被唤醒或超时
+     *
+     * @param addr
+     * @param expected
+     * @param timeout 毫秒, 小于0时不超时
+     * @return bool 超时返回false, 其余(唤醒/值已改变/虚假唤醒)返回true
+     */
+    static bool wait(std::atomic<int32_t> *addr, int32_t expected, int64_t timeout = -1);
+
+    /**
+     * @brief 唤醒最多n个等待在addr上的线程
+     *
+     * @param addr
+     * @param n
+     */
+    static void wake(std::atomic<int32_t> *addr, int32_t n);
+
+    /**
+     * @brief 唤醒所有等待在addr上的线程
+     *
+     * @param addr
+     */
+    static void wakeAll(std::atomic<int32_t> *addr);
+};
+
+/**
+ * @brief 计数信号量, 有可用计数时只有原子操作
+ */
+class SZ_Semaphore : public SZ_Uncopy
+{
+public:
+    explicit SZ_Semaphore(int32_t count = 0);
+
+    ~SZ_Semaphore();
+
+    /**
+     * @brief 获取一个计数
+     *
+     * @param timeout 毫秒, 小于0时一直等待
+     * @return bool 超时返回false
+     */
+    bool wait(int64_t timeout = -1);
+
+    /**
+     * @brief 不阻塞地获取一个计数
+     *
+     * @return bool
+     */
+    bool tryWait();
+
+    /**
+     * @brief 释放n个计数
+     *
+     * @param n
+     */
+    void post(int32_t n = 1);
+
+    /**
+     * @brief 当前可用计数
+     *
+     * @return int32_t
+     */
+    int32_t available() const;
+
+private:
+    std::atomic<int32_t> count_;
+    std::atomic<int32_t> waiters_;
+};
+
+/**
+ * @brief 一次性闩锁, 计数减到0后所有等待者放行
+ */
+class SZ_Latch : public SZ_Uncopy
+{
+public:
+    explicit SZ_Latch(int32_t count);
+
+    ~SZ_Latch();
+
+    /**
+     * @brief 计数减n
+     *
+     * @param n
+     */
+    void countDown(int32_t n = 1);
+
+    /**
+     * @brief 等待计数归零
+     *
+     * @param timeout 毫秒, 小于0时一直等待
+     * @return bool 超时返回false
+     */
+    bool wait(int64_t timeout = -1);
+
+    /**
+     * @brief 计数减1并等待归零
+     */
+    void arriveAndWait();
+
+    /**
+     * @brief 计数是否已归零
+     *
+     * @return bool
+     */
+    bool isReady() const;
+
+private:
+    std::atomic<int32_t> count_;
+    std::atomic<int32_t> waiters_;
+};
+
+/**
+ * @brief 可重复使用的屏障, 每凑齐count个线程放行一轮
+ */
+class SZ_Barrier : public SZ_Uncopy
+{
+public:
+    explicit SZ_Barrier(int32_t count);
+
+    ~SZ_Barrier();
+
+    /**
+     * @brief 到达并等待本轮其余线程
+     *
+     * @return bool 本轮最后到达的线程返回true
+     */
+    bool arriveAndWait();
+
+    /**
+     * @brief 已完成的轮数
+     *
+     * @return int32_t
+     */
+    int32_t generation() const;
+
+private:
+    const int32_t total_;
+    std::atomic<int32_t> count_;
+    std::atomic<int32_t> generation_;
+    std::atomic<int32_t> waiters_;
+};
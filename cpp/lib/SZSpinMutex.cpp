@@ -2,24 +2,92 @@
 
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <sstream>
 
-SZ_SpinMutex::SZ_SpinMutex()
+static int64_t nowns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void add(std::atomic<uint64_t> &counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+struct SZ_SpinMutex::Profile
+{
+    std::string name;
+    int64_t lockedAt;
+
+    std::atomic<uint64_t> acquisitions;
+    std::atomic<uint64_t> contended;
+    std::atomic<uint64_t> spins;
+    std::atomic<uint64_t> sleeps;
+    std::atomic<uint64_t> holdNs;
+    std::atomic<uint64_t> maxHoldNs;
+    std::atomic<uint64_t> holdHist[SZ_SpinMutexStats::HOLD_BUCKETS];
+
+    explicit Profile(const std::string &sName) : name(sName), lockedAt(0)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        acquisitions.store(0, std::memory_order_relaxed);
+        contended.store(0, std::memory_order_relaxed);
+        spins.store(0, std::memory_order_relaxed);
+        sleeps.store(0, std::memory_order_relaxed);
+        holdNs.store(0, std::memory_order_relaxed);
+        maxHoldNs.store(0, std::memory_order_relaxed);
+        for (auto &bucket : holdHist)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+#if defined SZ_SPINMUTEX_PROFILE
+std::atomic_bool SZ_SpinMutexRegistry::enabled_(true);
+#else
+std::atomic_bool SZ_SpinMutexRegistry::enabled_(false);
+#endif
+
+SZ_SpinMutex::SZ_SpinMutex() : SZ_SpinMutex("")
+{
+}
+
+SZ_SpinMutex::SZ_SpinMutex(const std::string &sName) : profile_(nullptr)
 {
     flag_.clear();
+
+    if (SZ_SpinMutexRegistry::enabled_.load(std::memory_order_relaxed))
+    {
+        profile_ = new Profile(sName);
+        SZ_SpinMutexRegistry::instance().attach(this);
+    }
 }
 
 SZ_SpinMutex::~SZ_SpinMutex()
 {
+    if (profile_)
+    {
+        SZ_SpinMutexRegistry::instance().detach(this);
+        delete profile_;
+    }
 }
 
 void SZ_SpinMutex::lock()
 {
     size_t i = 1;
+    size_t sleeps = 0;
     while (flag_.test_and_set())
     {
         if (i % 10 == 0)
         {
             std::this_thread::sleep_for(std::chrono::microseconds(10));
+            ++sleeps;
         }
         else
         {
@@ -27,6 +95,11 @@ void SZ_SpinMutex::lock()
         }
         ++i;
     }
+
+    if (profile_)
+    {
+        onAcquire(i - 1, sleeps);
+    }
 }
 
 bool SZ_SpinMutex::try_lock()
@@ -37,10 +110,189 @@ bool SZ_SpinMutex::try_lock()
         std::this_thread::yield();
     }
 
+    if (profile_ && times > 0)
+    {
+        onAcquire(10 - times, 0);
+    }
+
     return times > 0;
 }
 
 void SZ_SpinMutex::unlock()
 {
+    if (profile_)
+    {
+        onRelease();
+    }
     flag_.clear();
 }
+
+void SZ_SpinMutex::setName(const std::string &sName)
+{
+    if (profile_)
+    {
+        std::lock_guard<std::mutex> locker(SZ_SpinMutexRegistry::instance().mtx_);
+        profile_->name = sName;
+    }
+}
+
+SZ_SpinMutexStats SZ_SpinMutex::stats() const
+{
+    if (!profile_)
+    {
+        return SZ_SpinMutexStats();
+    }
+
+    std::lock_guard<std::mutex> locker(SZ_SpinMutexRegistry::instance().mtx_);
+    return collect();
+}
+
+void SZ_SpinMutex::resetStats()
+{
+    if (profile_)
+    {
+        profile_->reset();
+    }
+}
+
+SZ_SpinMutexStats SZ_SpinMutex::collect() const
+{
+    SZ_SpinMutexStats stats;
+    stats.name = profile_->name;
+    stats.acquisitions = profile_->acquisitions.load(std::memory_order_relaxed);
+    stats.contended = profile_->contended.load(std::memory_order_relaxed);
+    stats.spins = profile_->spins.load(std::memory_order_relaxed);
+    stats.sleeps = profile_->sleeps.load(std::memory_order_relaxed);
+    stats.holdNs = profile_->holdNs.load(std::memory_order_relaxed);
+    stats.maxHoldNs = profile_->maxHoldNs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < SZ_SpinMutexStats::HOLD_BUCKETS; ++i)
+    {
+        stats.holdHist[i] = profile_->holdHist[i].load(std::memory_order_relaxed);
+    }
+
+    return stats;
+}
+
+void SZ_SpinMutex::onAcquire(uint64_t spins, uint64_t sleeps)
+{
+    add(profile_->acquisitions, 1);
+    if (spins > 0)
+    {
+        add(profile_->contended, 1);
+        add(profile_->spins, spins);
+        add(profile_->sleeps, sleeps);
+    }
+    profile_->lockedAt = nowns();
+}
+
+void SZ_SpinMutex::onRelease()
+{
+    int64_t hold = nowns() - profile_->lockedAt;
+    uint64_t ns = hold > 0 ? static_cast<uint64_t>(hold) : 0;
+
+    size_t bucket = 0;
+    for (uint64_t v = ns >> 1; v > 0 && bucket < SZ_SpinMutexStats::HOLD_BUCKETS - 1; v >>= 1)
+    {
+        ++bucket;
+    }
+
+    add(profile_->holdHist[bucket], 1);
+    add(profile_->holdNs, ns);
+    if (ns > profile_->maxHoldNs.load(std::memory_order_relaxed))
+    {
+        profile_->maxHoldNs.store(ns, std::memory_order_relaxed);
+    }
+}
+
+SZ_SpinMutexRegistry::SZ_SpinMutexRegistry()
+{
+}
+
+SZ_SpinMutexRegistry &SZ_SpinMutexRegistry::instance()
+{
+    static SZ_SpinMutexRegistry registry;
+    return registry;
+}
+
+void SZ_SpinMutexRegistry::enable(bool on)
+{
+    enabled_.store(on);
+}
+
+bool SZ_SpinMutexRegistry::isEnabled() const
+{
+    return enabled_.load();
+}
+
+std::vector<SZ_SpinMutexStats> SZ_SpinMutexRegistry::top(size_t n) const
+{
+    std::vector<SZ_SpinMutexStats> vStats;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        for (auto mutex : mutexes_)
+        {
+            vStats.push_back(mutex->collect());
+        }
+    }
+
+    std::sort(vStats.begin(), vStats.end(), [](const SZ_SpinMutexStats &a, const SZ_SpinMutexStats &b)
+              { return a.contended != b.contended ? a.contended > b.contended : a.spins > b.spins; });
+
+    if (n > 0 && vStats.size() > n)
+    {
+        vStats.resize(n);
+    }
+
+    return vStats;
+}
+
+std::string SZ_SpinMutexRegistry::dump(size_t n) const
+{
+    std::ostringstream os;
+    for (auto &stats : top(n))
+    {
+        os << "[" << (stats.name.empty() ? "unnamed" : stats.name) << "]"
+           << " acquisitions=" << stats.acquisitions
+           << " contended=" << stats.contended
+           << " spins=" << stats.spins
+           << " sleeps=" << stats.sleeps
+           << " hold_avg_ns=" << (stats.acquisitions > 0 ? stats.holdNs / stats.acquisitions : 0)
+           << " hold_max_ns=" << stats.maxHoldNs
+           << " hold_hist=";
+
+        bool isFirst = true;
+        for (size_t i = 0; i < SZ_SpinMutexStats::HOLD_BUCKETS; ++i)
+        {
+            if (stats.holdHist[i] == 0)
+            {
+                continue;
+            }
+            os << (isFirst ? "" : ",") << (1ULL << i) << ":" << stats.holdHist[i];
+            isFirst = false;
+        }
+        os << "\n";
+    }
+
+    return os.str();
+}
+
+void SZ_SpinMutexRegistry::reset()
+{
+    std::lock_guard<std::mutex> locker(mtx_);
+    for (auto mutex : mutexes_)
+    {
+        mutex->resetStats();
+    }
+}
+
+void SZ_SpinMutexRegistry::attach(SZ_SpinMutex *mutex)
+{
+    std::lock_guard<std::mutex> locker(mtx_);
+    mutexes_.insert(mutex);
+}
+
+void SZ_SpinMutexRegistry::detach(SZ_SpinMutex *mutex)
+{
+    std::lock_guard<std::mutex> locker(mtx_);
+    mutexes_.erase(mutex);
+}
@@ -3,12 +3,37 @@
 #include "SZUtility.h"
 
 #include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 自旋锁统计快照
+ */
+struct SZ_SpinMutexStats
+{
+    static constexpr size_t HOLD_BUCKETS = 32; // 持有时长直方图, 第i桶为[2^i, 2^(i+1))纳秒
+
+    std::string name;
+    uint64_t acquisitions; // 加锁次数
+    uint64_t contended;    // 首次尝试失败的加锁次数
+    uint64_t spins;        // 总自旋次数
+    uint64_t sleeps;       // 总休眠次数
+    uint64_t holdNs;       // 总持有时长
+    uint64_t maxHoldNs;    // 最长持有时长
+    uint64_t holdHist[HOLD_BUCKETS];
+
+    SZ_SpinMutexStats() : acquisitions(0), contended(0), spins(0), sleeps(0), holdNs(0), maxHoldNs(0), holdHist() {}
+};
 
 class SZ_SpinMutex : public SZ_Uncopy
 {
 public:
     SZ_SpinMutex();
 
+    explicit SZ_SpinMutex(const std::string &sName);
+
     ~SZ_SpinMutex();
 
     void lock();
@@ -17,6 +42,118 @@ public:
 
     void unlock();
 
+    /**
+     * @brief 设置名称, 用于统计输出, 未开启统计时忽略
+     *
+     * @param sName
+     */
+    void setName(const std::string &sName);
+
+    /**
+     * @brief 是否开启统计
+     *
+     * @return bool
+     */
+    bool isProfiled() const { return nullptr != profile_; }
+
+    /**
+     * @brief 统计快照, 未开启统计时各项为0
+     *
+     * @return SZ_SpinMutexStats
+     */
+    SZ_SpinMutexStats stats() const;
+
+    /**
+     * @brief 清空统计
+     */
+    void resetStats();
+
+protected:
+    struct Profile;
+
+    /**
+     * @brief 读取计数, 调用方需持有注册表锁以保护名称
+     *
+     * @return SZ_SpinMutexStats
+     */
+    SZ_SpinMutexStats collect() const;
+
+    /**
+     * @brief 加锁成功后记录, 此时持有锁, 计数只有一个写者
+     *
+     * @param spins
+     * @param sleeps
+     */
+    void onAcquire(uint64_t spins, uint64_t sleeps);
+
+    /**
+     * @brief 解锁前记录持有时长
+     */
+    void onRelease();
+
 private:
+    friend class SZ_SpinMutexRegistry;
+
     std::atomic_flag flag_;
+    Profile *profile_; // 统计数据, 只在构造时开启了统计才分配, 否则为空
+};
+
+/**
+ * @brief 自旋锁统计注册表
+ *        定义SZ_SPINMUTEX_PROFILE时默认开启, 也可运行期调用enable开启
+ *        开关只影响之后构造的锁
+ */
+class SZ_SpinMutexRegistry : public SZ_Uncopy
+{
+public:
+    static SZ_SpinMutexRegistry &instance();
+
+    /**
+     * @brief 开启或关闭统计
+     *
+     * @param on
+     */
+    void enable(bool on);
+
+    /**
+     * @brief 是否开启统计
+     *
+     * @return bool
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief 按竞争次数降序返回前n把锁的统计
+     *
+     * @param n 为0时返回全部
+     * @return std::vector<SZ_SpinMutexStats>
+     */
+    std::vector<SZ_SpinMutexStats> top(size_t n = 0) const;
+
+    /**
+     * @brief 以文本形式输出竞争最多的前n把锁, 每行一把
+     *
+     * @param n
+     * @return std::string
+     */
+    std::string dump(size_t n = 10) const;
+
+    /**
+     * @brief 清空所有已注册锁的统计
+     */
+    void reset();
+
+protected:
+    SZ_SpinMutexRegistry();
+
+    void attach(SZ_SpinMutex *mutex);
+
+    void detach(SZ_SpinMutex *mutex);
+
+private:
+    friend class SZ_SpinMutex;
+
+    static std::atomic_bool enabled_; // 常量初始化, 构造锁时无需先构造注册表
+    mutable std::mutex mtx_;
+    std::set<SZ_SpinMutex *> mutexes_;
 };
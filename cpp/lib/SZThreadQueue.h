@@ -40,13 +40,20 @@ public:
 			queue_.swap(temp);
 			size_.store(0);
 		}
+		condFull_.notify_all();
 	}
 
 	size_t capacity(size_t cap = 0)
 	{
 		if (cap > 0)
 		{
-			return capacity_.exchange(cap);
+			size_t old;
+			{
+				std::lock_guard<std::mutex> locker(mtx_);
+				old = capacity_.exchange(cap);
+			}
+			condFull_.notify_all();
+			return old;
 		}
 
 		return capacity_.load();
@@ -71,6 +78,44 @@ public:
 		return hadPush;
 	}
 
+	/**
+	 * @brief 队列满时等待出队
+	 *
+	 * @param element
+	 * @param timeout 毫秒, -1为一直等待, 0与push(element)相同
+	 * @return bool 超时返回false
+	 */
+	bool push(const value_type &element, int64_t timeout)
+	{
+		{
+			std::unique_lock<std::mutex> locker(mtx_);
+
+			auto notFull = [&]
+			{ return size_.load() < capacity_.load(); };
+			if (!notFull() && timeout != 0)
+			{
+				if (timeout < 0)
+				{
+					condFull_.wait(locker, notFull);
+				}
+				else
+				{
+					condFull_.wait_for(locker, std::chrono::milliseconds(timeout), notFull);
+				}
+			}
+
+			if (!notFull())
+			{
+				return false;
+			}
+			queue_.emplace(element);
+			++size_;
+		}
+		cond_.notify_one();
+
+		return true;
+	}
+
 	bool pop(value_type &element, int64_t timeout = -1)
 	{
 		std::unique_lock<std::mutex> locker(mtx_);
@@ -94,6 +139,8 @@ public:
 			element = std::move(queue_.front());
 			queue_.pop();
 			--size_;
+			locker.unlock();
+			condFull_.notify_one();
 			return true;
 		}
 
@@ -102,9 +149,12 @@ public:
 
 	bool swap(Container &que)
 	{
-		std::lock_guard<std::mutex> locker(mtx_);
-		queue_.swap(que);
-		size_.store(queue_.size());
+		{
+			std::lock_guard<std::mutex> locker(mtx_);
+			queue_.swap(que);
+			size_.store(queue_.size());
+		}
+		condFull_.notify_all();
 
 		return true;
 	}
@@ -112,6 +162,7 @@ public:
 private:
 	std::mutex mtx_;
 	std::condition_variable cond_;
+	std::condition_variable condFull_; // push(element, timeout)等待未满
 	std::atomic_size_t size_;
 	std::atomic_size_t capacity_;
 	container_type queue_;
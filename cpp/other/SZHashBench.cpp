@@ -0,0 +1,563 @@
+/**
+ * @brief 哈希吞吐基准
+ *        覆盖SZ_MD5的md5bin/md5str/md5file、SZ_MD5Multi批量计算、SZ_XXH3/SZ_CRC32C/SZ_SHA256,
+ *        输入从16B到1GB, 输出MB/s与每字节周期数, 并统计多线程扩展性
+ *        运行前先执行已知答案测试, 任一引擎结果错误时不再计时, 以非0退出
+ *        每条结果输出为一行JSON, 便于不同版本之间比较:
+ *        {"bench":"md5bin","size":4096,"threads":1,"iters":...,"ns":...,"mbps":...,"cpb":...}
+ *        cpb以TSC计数, 与实际核心频率可能不同, 只用于同一机器上的前后对比; 非x86平台为0
+ *
+ *        g++ -std=c++11 -O2 -I../lib SZHashBench.cpp ../lib/SZCommon.cpp ../lib/SZSpinMutex.cpp
+ *            ../lib/SZMD5.cpp ../lib/SZMD5Multi.cpp ../lib/SZMD5Tree.cpp ../lib/SZHash.cpp -lpthread -o SZHashBench
+ *
+ *        SZHashBench [--max-size 字节] [--min-time 毫秒] [--threads 最大线程数] [--dir 临时文件目录] [--kat-only]
+ */
+
+#include "SZCommon.h"
+#include "SZHash.h"
+#include "SZMD5.h"
+#include "SZMD5Multi.h"
+#include "SZMD5Tree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if defined SZ_TARGET_PLATFORM_WINDOWS
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define SZ_BENCH_HAS_TSC 1
+#endif
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct Options
+    {
+        uint64_t maxSize = 1ULL << 30;
+        int64_t minTime = 200;
+        size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        std::string dir = "/tmp";
+        bool katOnly = false;
+    };
+
+    struct Sample
+    {
+        uint64_t iters = 0;
+        uint64_t ns = 0;
+        uint64_t ticks = 0;
+    };
+
+    uint64_t nowNs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    uint64_t ticks()
+    {
+#if defined SZ_BENCH_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // 防止被测调用的结果被优化掉
+    volatile uint64_t g_sink = 0;
+
+    void sink(const void *data, size_t length)
+    {
+        if (length > 0)
+        {
+            g_sink += static_cast<const unsigned char *>(data)[0];
+        }
+    }
+
+    /**
+     * @brief 重复执行直到累计时长不少于minTime, 小输入每轮批量调用以摊薄计时开销
+     *
+     * @param length 每次调用处理的字节数
+     * @param minTime 毫秒
+     * @param func 执行一次
+     * @return Sample
+     */
+    template <typename Func>
+    Sample measure(uint64_t length, int64_t minTime, Func func)
+    {
+        uint64_t batch = std::max<uint64_t>(1, (256 * 1024) / std::max<uint64_t>(length, 1));
+        uint64_t limit = static_cast<uint64_t>(minTime) * 1000000;
+
+        func(); // 预热
+
+        Sample sample;
+        uint64_t t0 = nowNs();
+        uint64_t c0 = ticks();
+        do
+        {
+            for (uint64_t i = 0; i < batch; ++i)
+            {
+                func();
+            }
+            sample.iters += batch;
+            sample.ns = nowNs() - t0;
+        } while (sample.ns < limit);
+        sample.ticks = ticks() - c0;
+
+        return sample;
+    }
+
+    void report(const char *bench, uint64_t size, size_t threads, const Sample &sample)
+    {
+        double bytes = static_cast<double>(size) * static_cast<double>(sample.iters);
+        double mbps = sample.ns > 0 ? bytes / (1024.0 * 1024.0) / (static_cast<double>(sample.ns) / 1e9) : 0.0;
+        double cpb = bytes > 0 ? static_cast<double>(sample.ticks) / bytes : 0.0;
+        printf("{\"bench\":\"%s\",\"size\":%llu,\"threads\":%zu,\"iters\":%llu,\"ns\":%llu,\"mbps\":%.2f,\"cpb\":%.3f}\n",
+               bench, static_cast<unsigned long long>(size), threads, static_cast<unsigned long long>(sample.iters),
+               static_cast<unsigned long long>(sample.ns), mbps, cpb);
+        fflush(stdout);
+    }
+
+    std::vector<uint64_t> sizes(uint64_t maxSize)
+    {
+        std::vector<uint64_t> vSizes;
+        for (uint64_t size = 16; size <= maxSize; size *= 4)
+        {
+            vSizes.push_back(size);
+        }
+
+        return vSizes;
+    }
+
+    /**
+     * @brief 已知答案测试
+     */
+    class Kat
+    {
+    public:
+        void check(const char *name, const std::string &got, const std::string &expected)
+        {
+            ++total_;
+            if (got != expected)
+            {
+                ++failed_;
+                fprintf(stderr, "KAT FAILED %s: got %s, expected %s\n", name, got.c_str(), expected.c_str());
+            }
+        }
+
+        bool run(const std::string &dir)
+        {
+            static const char *MD5_VECTORS[][2] = {
+                {"", "d41d8cd98f00b204e9800998ecf8427e"},
+                {"a", "0cc175b9c0f1b6a831c399e269772661"},
+                {"abc", "900150983cd24fb0d6963f7d28e17f72"},
+                {"message digest", "f96b697d7cb7938d525a2f31aaf161d0"},
+                {"abcdefghijklmnopqrstuvwxyz", "c3fcd3d76192e4007dfb496cca67e13b"},
+                {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", "d174ab98d277d9f5a5611c2c9f419d9f"},
+                {"12345678901234567890123456789012345678901234567890123456789012345678901234567890", "57edf4a22be3c955ac49da2e2107b67a"},
+            };
+
+            std::vector<std::string> vMessages;
+            for (auto &v : MD5_VECTORS)
+            {
+                std::string message(v[0]);
+                check("md5str", SZ_MD5::md5str(message), v[1]);
+                check("md5digest", SZ_MD5::md5digest(message).str(), v[1]);
+
+                std::vector<char> vBin = SZ_MD5::md5bin(message);
+                std::string hex(32, '\0');
+                SZ_MD5::hexEncode(vBin.data(), vBin.size(), &hex[0]);
+                check("md5bin", hex, v[1]);
+
+                // 逐字节输入与一次输入结果应相同
+                SZ_MD5Hasher hasher;
+                for (char c : message)
+                {
+                    hasher.update(&c, 1);
+                }
+                check("SZ_MD5Hasher", hasher.finalizeStr(), v[1]);
+
+                vMessages.push_back(message);
+            }
+
+            std::string million(1000000, 'a');
+            check("md5str 1M", SZ_MD5::md5str(million), "7707d6ae4e027c70eea2a935c2296f21");
+
+            // 各引擎的多路计算须与逐条计算一致, 长度覆盖各填充边界
+            for (size_t length = 0; length <= 200; ++length)
+            {
+                std::string message(length, '\0');
+                for (size_t i = 0; i < length; ++i)
+                {
+                    message[i] = static_cast<char>(i * 131 + length);
+                }
+                vMessages.push_back(message);
+            }
+            SZ_MD5Multi::Engine original = SZ_MD5Multi::engine();
+            SZ_MD5Multi::Engine engines[] = {SZ_MD5Multi::ENGINE_SCALAR, SZ_MD5Multi::ENGINE_AVX2, SZ_MD5Multi::ENGINE_AVX512};
+            for (auto eng : engines)
+            {
+                if (SZ_MD5Multi::setEngine(eng) != eng)
+                {
+                    continue;
+                }
+                std::vector<std::string> vDigests = SZ_MD5Multi::md5str(vMessages);
+                for (size_t i = 0; i < vMessages.size(); ++i)
+                {
+                    check(("SZ_MD5Multi engine " + std::to_string(static_cast<int>(eng))).c_str(), vDigests[i], SZ_MD5::md5str(vMessages[i]));
+                }
+            }
+            SZ_MD5Multi::setEngine(original);
+
+            check("sha256str", SZ_SHA256::sha256str(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+            check("sha256str", SZ_SHA256::sha256str("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+            check("sha256str 1M", SZ_SHA256::sha256str(million), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+            check("crc32c", std::to_string(SZ_CRC32C::checksum("123456789", 9)), std::to_string(0xe3069283U));
+            check("xxh3", std::to_string(SZ_XXH3::hash("", 0)), std::to_string(0x2d06800538d394c2ULL));
+            check("xxh3", std::to_string(SZ_XXH3::hash("abc", 3)), std::to_string(0x78af5f94892f3950ULL));
+            check("xxh3", std::to_string(SZ_XXH3::hash(std::string(1000, 'a'))), std::to_string(0xb3e7af627147db7cULL));
+
+            // 各读取方式的md5file须与内存计算一致
+            std::string fileName = dir + "/SZHashBench.kat";
+            FILE *f = fopen(fileName.c_str(), "wb");
+            if (nullptr != f)
+            {
+                std::string content(3 * 1024 * 1024 + 17, '\0');
+                for (size_t i = 0; i < content.size(); ++i)
+                {
+                    content[i] = static_cast<char>(i * 7 + (i >> 12));
+                }
+                fwrite(content.data(), 1, content.size(), f);
+                fclose(f);
+
+                std::string expected = SZ_MD5::md5str(content);
+                SZ_MD5::IOStrategy strategies[] = {SZ_MD5::IO_AUTO, SZ_MD5::IO_STDIO, SZ_MD5::IO_MMAP, SZ_MD5::IO_BUFFER, SZ_MD5::IO_DIRECT};
+                for (auto strategy : strategies)
+                {
+                    check(("md5file strategy " + std::to_string(static_cast<int>(strategy))).c_str(), SZ_MD5::md5file(fileName, strategy), expected);
+                }
+                remove(fileName.c_str());
+            }
+            else
+            {
+                fprintf(stderr, "KAT skipped md5file: can not create %s\n", fileName.c_str());
+            }
+
+            printf("{\"kat\":\"md5,md5multi,sha256,crc32c,xxh3,md5file\",\"total\":%zu,\"failed\":%zu}\n", total_, failed_);
+            fflush(stdout);
+
+            return failed_ == 0;
+        }
+
+    private:
+        size_t total_ = 0;
+        size_t failed_ = 0;
+    };
+
+    void benchMemory(const Options &options, const std::vector<char> &vBuffer)
+    {
+        const char *data = vBuffer.data();
+        for (uint64_t size : sizes(options.maxSize))
+        {
+            size_t n = static_cast<size_t>(size);
+
+            report("md5bin", size, 1, measure(size, options.minTime, [data, n]()
+                                              { std::vector<char> v = SZ_MD5::md5bin(data, n); sink(v.data(), v.size()); }));
+            report("md5digest", size, 1, measure(size, options.minTime, [data, n]()
+                                                 { SZ_MD5Digest d = SZ_MD5::md5digest(data, n); sink(d.bytes.data(), d.bytes.size()); }));
+            // 与md5digest之差即十六进制格式化及字符串分配的开销
+            report("md5str", size, 1, measure(size, options.minTime, [data, n]()
+                                              { std::string s = SZ_MD5::md5str(data, n); sink(s.data(), s.size()); }));
+            report("sha256bin", size, 1, measure(size, options.minTime, [data, n]()
+                                                 { std::vector<char> v = SZ_SHA256::sha256bin(data, n); sink(v.data(), v.size()); }));
+            report("crc32c", size, 1, measure(size, options.minTime, [data, n]()
+                                              { uint32_t v = SZ_CRC32C::checksum(data, n); sink(&v, sizeof(v)); }));
+            report("xxh3", size, 1, measure(size, options.minTime, [data, n]()
+                                            { uint64_t v = SZ_XXH3::hash(data, n); sink(&v, sizeof(v)); }));
+
+            // 多路计算: 同时计算16条等长消息, size为单条长度
+            if (size <= 1024 * 1024 && size * 16 <= vBuffer.size())
+            {
+                const char *buffers[16];
+                size_t lengths[16];
+                for (size_t i = 0; i < 16; ++i)
+                {
+                    buffers[i] = data + i * n;
+                    lengths[i] = n;
+                }
+                SZ_MD5Multi::Digest digests[16];
+                Sample sample = measure(size * 16, options.minTime, [&buffers, &lengths, &digests]()
+                                        { SZ_MD5Multi::md5bin(buffers, lengths, 16, digests); sink(digests[0].bytes.data(), digests[0].bytes.size()); });
+                sample.iters *= 16;
+                report("md5multi", size, 1, sample);
+            }
+        }
+
+        // 仅格式化16字节摘要
+        SZ_MD5Digest digest = SZ_MD5::md5digest(data, 16);
+        report("md5hex", 16, 1, measure(16, options.minTime, [&digest]()
+                                        { char out[32]; digest.hex(out); sink(out, sizeof(out)); }));
+    }
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+    /**
+     * @brief 丢弃文件的页缓存, 文件须已落盘
+     *
+     * @param fileName
+     * @return bool
+     */
+    bool dropCache(const std::string &fileName)
+    {
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool ok = ::fdatasync(fd) == 0 && ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        ::close(fd);
+
+        return ok;
+    }
+#endif
+
+    void benchFile(const Options &options, const std::vector<char> &vBuffer)
+    {
+        static const struct
+        {
+            SZ_MD5::IOStrategy strategy;
+            const char *name;
+            bool warm; // IO_DIRECT不经页缓存, 总是冷读, 不测热缓存
+        } STRATEGIES[] = {
+            {SZ_MD5::IO_STDIO, "stdio", true},
+            {SZ_MD5::IO_MMAP, "mmap", true},
+            {SZ_MD5::IO_BUFFER, "buffer", true},
+            {SZ_MD5::IO_DIRECT, "direct", false},
+        };
+
+        std::string fileName = options.dir + "/SZHashBench.dat";
+        for (uint64_t size : sizes(options.maxSize))
+        {
+            if (size < 4096)
+            {
+                continue;
+            }
+
+            FILE *f = fopen(fileName.c_str(), "wb");
+            if (nullptr == f)
+            {
+                fprintf(stderr, "Can not create %s, skip md5file\n", fileName.c_str());
+                return;
+            }
+            bool written = fwrite(vBuffer.data(), 1, static_cast<size_t>(size), f) == size;
+            fclose(f);
+            if (!written)
+            {
+                fprintf(stderr, "Write %s failed, skip md5file\n", fileName.c_str());
+                remove(fileName.c_str());
+                return;
+            }
+
+            for (auto &s : STRATEGIES)
+            {
+                SZ_MD5::IOStrategy strategy = s.strategy;
+                std::string bench;
+                if (s.warm)
+                {
+                    bench = std::string("md5file_warm_") + s.name;
+                    report(bench.c_str(), size, 1, measure(size, options.minTime, [&fileName, strategy]()
+                                                           { std::string v = SZ_MD5::md5file(fileName, strategy); sink(v.data(), v.size()); }));
+                }
+
+#if defined SZ_TARGET_PLATFORM_LINUX
+                // 每次计算前丢弃页缓存, 计时不含丢弃本身
+                if (!dropCache(fileName))
+                {
+                    continue;
+                }
+                Sample sample;
+                uint64_t limit = static_cast<uint64_t>(options.minTime) * 1000000;
+                do
+                {
+                    dropCache(fileName);
+                    uint64_t t0 = nowNs();
+                    uint64_t c0 = ticks();
+                    std::string v = SZ_MD5::md5file(fileName, strategy);
+                    sample.ticks += ticks() - c0;
+                    sample.ns += nowNs() - t0;
+                    sink(v.data(), v.size());
+                    ++sample.iters;
+                } while (sample.ns < limit);
+                bench = std::string("md5file_cold_") + s.name;
+                report(bench.c_str(), size, 1, sample);
+#endif
+            }
+        }
+        remove(fileName.c_str());
+    }
+
+    /**
+     * @brief 每个线程独立计算各自的缓冲区, 统计合计吞吐
+     */
+    void benchScaling(const Options &options, const std::vector<char> &vBuffer)
+    {
+        static const uint64_t SIZES[] = {4096, 1024 * 1024};
+
+        for (uint64_t size : SIZES)
+        {
+            if (size > options.maxSize)
+            {
+                continue;
+            }
+
+            for (size_t threads = 1; threads <= options.threads; threads = threads < options.threads ? std::min(threads * 2, options.threads) : threads + 1)
+            {
+                std::atomic<bool> start(false);
+                std::atomic<bool> stop(false);
+                std::vector<uint64_t> vIters(threads, 0);
+                std::vector<std::thread> vThreads;
+                for (size_t t = 0; t < threads; ++t)
+                {
+                    const char *data = vBuffer.data() + (t * size) % (vBuffer.size() - size + 1);
+                    uint64_t *iters = &vIters[t];
+                    vThreads.emplace_back([data, size, iters, &start, &stop]()
+                                          {
+                                              while (!start.load(std::memory_order_acquire))
+                                              {
+                                                  std::this_thread::yield();
+                                              }
+                                              uint64_t n = 0;
+                                              while (!stop.load(std::memory_order_relaxed))
+                                              {
+                                                  SZ_MD5Digest d = SZ_MD5::md5digest(data, static_cast<size_t>(size));
+                                                  sink(d.bytes.data(), d.bytes.size());
+                                                  ++n;
+                                              }
+                                              *iters = n; });
+                }
+
+                Sample sample;
+                uint64_t t0 = nowNs();
+                uint64_t c0 = ticks();
+                start.store(true, std::memory_order_release);
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.minTime));
+                stop.store(true, std::memory_order_relaxed);
+                for (auto &thread : vThreads)
+                {
+                    thread.join();
+                }
+                sample.ns = nowNs() - t0;
+                sample.ticks = (ticks() - c0) * threads;
+                for (auto n : vIters)
+                {
+                    sample.iters += n;
+                }
+                report("md5digest_mt", size, threads, sample);
+            }
+        }
+
+        // 单条大输入借助哈希树并行
+        uint64_t size = std::min<uint64_t>(options.maxSize, 256ULL * 1024 * 1024);
+        if (size >= 1024 * 1024)
+        {
+            for (size_t threads = 1; threads <= options.threads; threads = threads < options.threads ? std::min(threads * 2, options.threads) : threads + 1)
+            {
+                SZ_MD5Tree tree(threads, 1024 * 1024);
+                const char *data = vBuffer.data();
+                report("md5tree", size, threads, measure(size, options.minTime, [&tree, data, size]()
+                                                         { std::string v = tree.hash(data, static_cast<size_t>(size)); sink(v.data(), v.size()); }));
+            }
+        }
+    }
+
+    bool parseOptions(int argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            bool hasValue = i + 1 < argc;
+            if (arg == "--max-size" && hasValue)
+            {
+                options.maxSize = strtoull(argv[++i], nullptr, 10);
+            }
+            else if (arg == "--min-time" && hasValue)
+            {
+                options.minTime = strtoll(argv[++i], nullptr, 10);
+            }
+            else if (arg == "--threads" && hasValue)
+            {
+                options.threads = static_cast<size_t>(strtoull(argv[++i], nullptr, 10));
+            }
+            else if (arg == "--dir" && hasValue)
+            {
+                options.dir = argv[++i];
+            }
+            else if (arg == "--kat-only")
+            {
+                options.katOnly = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return options.maxSize >= 16 && options.minTime > 0 && options.threads > 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "Usage: %s [--max-size bytes] [--min-time ms] [--threads n] [--dir path] [--kat-only]\n", argv[0]);
+        return 2;
+    }
+
+    Kat kat;
+    if (!kat.run(options.dir))
+    {
+        return 1;
+    }
+    if (options.katOnly)
+    {
+        return 0;
+    }
+
+    // 多路计算需要16条消息, 缓冲区至少16MB; 内容取伪随机, 避免全零页被特殊处理
+    std::vector<char> vBuffer(static_cast<size_t>(std::max<uint64_t>(options.maxSize, 16 * 1024 * 1024)));
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (auto &c : vBuffer)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        c = static_cast<char>(x);
+    }
+
+    printf("{\"md5multi_engine\":%d,\"sha256_hardware\":%s,\"crc32c_hardware\":%s,\"tsc\":%s}\n",
+           static_cast<int>(SZ_MD5Multi::engine()), SZ_SHA256::hardware() ? "true" : "false", SZ_CRC32C::hardware() ? "true" : "false",
+#if defined SZ_BENCH_HAS_TSC
+           "true"
+#else
+           "false"
+#endif
+    );
+
+    benchMemory(options, vBuffer);
+    benchFile(options, vBuffer);
+    benchScaling(options, vBuffer);
+
+    return 0;
+}